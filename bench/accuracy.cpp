@@ -0,0 +1,258 @@
+/**
+ * @file bench/accuracy.cpp
+ * @brief Bias and RMSE of the estimates across cardinalities and precisions
+ * @author Daniil Dudkin (unterumarmung)
+ *
+ * Every trial adds a stream of provably distinct values: splitmix64 outputs of distinct states,
+ * so the true cardinality is the number of added values and no exact set is needed.
+ * Trials run in parallel; the relative errors are aggregated per precision and cardinality checkpoint.
+ */
+#include <algorithm> // std::max
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bench/common.hxx"
+#include "hll/crc32c.hxx"
+#include "hll/hyper_log_log.hxx"
+
+namespace
+{
+
+struct options
+{
+    uint64_t max_n = 1000000;
+    std::size_t trials = 64;
+    std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    uint64_t seed = 1;
+    std::string hash = "murmur3";
+};
+
+constexpr std::size_t min_k = 4;
+constexpr std::size_t max_k = 18;
+constexpr std::size_t k_step = 2;
+constexpr std::size_t precisions_count = (max_k - min_k) / k_step + 1;
+
+/**
+ * Cardinality checkpoints: 1, 2, 5, 10, 20, 50... up to max_n
+ */
+std::vector<uint64_t> make_checkpoints(uint64_t max_n)
+{
+    std::vector<uint64_t> result;
+    for (uint64_t decade = 1; decade <= max_n; decade *= 10)
+    {
+        for (const uint64_t step : {1, 2, 5})
+        {
+            if (decade * step <= max_n)
+                result.push_back(decade * step);
+        }
+        if (decade > max_n / 10)
+            break;
+    }
+    return result;
+}
+
+/**
+ * Sketches of all the swept precisions, fed with the same stream
+ */
+template<typename Hash, std::size_t k = min_k>
+struct sketch_set
+{
+    hll::hyper_log_log<uint64_t, k, Hash> sketch;
+    sketch_set<Hash, k + k_step> rest;
+
+    void add(uint64_t value)
+    {
+        sketch.add(value);
+        rest.add(value);
+    }
+
+    void estimate(double* out) const
+    {
+        *out = static_cast<double>(sketch.count());
+        rest.estimate(out + 1);
+    }
+
+    static void relative_errors(double* out)
+    {
+        *out = 1.04 / std::sqrt(static_cast<double>(hll::hyper_log_log<uint64_t, k, Hash>::registers_count));
+        sketch_set<Hash, k + k_step>::relative_errors(out + 1);
+    }
+};
+
+template<typename Hash>
+struct sketch_set<Hash, max_k + k_step>
+{
+    void add(uint64_t)
+    {
+    }
+
+    void estimate(double*) const
+    {
+    }
+
+    static void relative_errors(double*)
+    {
+    }
+};
+
+/**
+ * Runs the trials on several threads
+ * @return relative errors indexed by [trial][checkpoint][precision]
+ */
+template<typename Hash>
+std::vector<double> run_trials(const options& opts, const std::vector<uint64_t>& checkpoints)
+{
+    const auto stride = checkpoints.size() * precisions_count;
+    std::vector<double> errors(opts.trials * stride);
+    std::atomic<std::size_t> next_trial{0};
+
+    const auto work = [&]
+    {
+        std::unique_ptr<sketch_set<Hash>> sketches;
+        for (auto trial = next_trial++; trial < opts.trials; trial = next_trial++)
+        {
+            sketches.reset(new sketch_set<Hash>{});
+            // a random starting state per trial, the values within a trial are distinct as the state never repeats
+            auto trial_state = opts.seed ^ (trial * 0x2545f4914f6cdd1d);
+            auto state = hll::bench::splitmix64(trial_state);
+            uint64_t added = 0;
+            for (std::size_t c = 0; c < checkpoints.size(); ++c)
+            {
+                for (; added < checkpoints[c]; ++added)
+                {
+                    sketches->add(hll::bench::splitmix64(state));
+                }
+
+                const auto out = errors.data() + trial * stride + c * precisions_count;
+                sketches->estimate(out);
+                for (std::size_t p = 0; p < precisions_count; ++p)
+                {
+                    out[p] = out[p] / static_cast<double>(added) - 1.0;
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (std::size_t i = 1; i < opts.threads; ++i)
+    {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+    return errors;
+}
+
+template<typename Hash>
+void report(const options& opts)
+{
+    const auto checkpoints = make_checkpoints(opts.max_n);
+    const auto errors = run_trials<Hash>(opts, checkpoints);
+    double bounds[precisions_count];
+    sketch_set<Hash>::relative_errors(bounds);
+
+    std::printf("# hash\tk\tn\ttrials\tbias\trmse\tbound\trmse/bound\n");
+    for (std::size_t p = 0; p < precisions_count; ++p)
+    {
+        for (std::size_t c = 0; c < checkpoints.size(); ++c)
+        {
+            double sum = 0;
+            double squares = 0;
+            for (std::size_t trial = 0; trial < opts.trials; ++trial)
+            {
+                const auto error = errors[(trial * checkpoints.size() + c) * precisions_count + p];
+                sum += error;
+                squares += error * error;
+            }
+            const auto bias = sum / opts.trials;
+            const auto rmse = std::sqrt(squares / opts.trials);
+            std::printf("%s\t%zu\t%llu\t%zu\t%+.5f\t%.5f\t%.5f\t%.3f\n", opts.hash.c_str(), min_k + p * k_step,
+                        static_cast<unsigned long long>(checkpoints[c]), opts.trials, bias, rmse, bounds[p],
+                        rmse / bounds[p]);
+        }
+    }
+}
+
+void print_usage(std::FILE* stream)
+{
+    std::fprintf(stream, "usage: hll_accuracy [-n MAX_N] [-t TRIALS] [-j THREADS] [-s SEED] [--hash NAME]\n"
+                         "Prints bias and RMSE of the relative error for k = %zu, %zu, ..., %zu\n"
+                         "at cardinalities 1, 2, 5, 10, ... up to MAX_N (1e6 by default, up to 1e10 and beyond).\n"
+                         "  --hash NAME  murmur3 (default), murmur64a or crc32c\n", min_k, min_k + k_step, max_k);
+}
+
+bool parse_options(int argc, char** argv, options& result)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string argument = argv[i];
+        if (argument == "-h" || argument == "--help")
+        {
+            print_usage(stdout);
+            std::exit(0);
+        }
+        if (++i == argc)
+            return false;
+
+        char* end = nullptr;
+        if (argument == "--hash")
+        {
+            result.hash = argv[i];
+            continue;
+        }
+        // accept 1e10 as well as 10000000000
+        const auto value = static_cast<uint64_t>(std::strtod(argv[i], &end));
+        if (*end != '\0' || value == 0)
+            return false;
+
+        if (argument == "-n")
+            result.max_n = value;
+        else if (argument == "-t")
+            result.trials = static_cast<std::size_t>(value);
+        else if (argument == "-j")
+            result.threads = static_cast<std::size_t>(value);
+        else if (argument == "-s")
+            result.seed = value;
+        else
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    options opts;
+    if (!parse_options(argc, argv, opts))
+    {
+        print_usage(stderr);
+        return 2;
+    }
+
+    if (opts.hash == "murmur3")
+    {
+        report<hll::murmur3_hash>(opts);
+    } else if (opts.hash == "murmur64a")
+    {
+        report<hll::murmur64a_hash>(opts);
+    } else if (opts.hash == "crc32c")
+    {
+        report<hll::crc32c_hash>(opts);
+    } else
+    {
+        print_usage(stderr);
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,197 @@
+/**
+ * @file bench/benchmark.cpp
+ * @brief Speed of add, range add, adding precomputed hashes, count and merge and memory per sketch across precisions and value types,
+ * and of add and range add of the sketch with the runtime precision
+ * @author Daniil Dudkin (unterumarmung)
+ *
+ * Inputs are generated from fixed seeds and the output is one tab-separated line per measurement
+ * in a fixed order, so outputs of two versions can be compared line by line.
+ * `--level scalar|sse4.2|avx2|avx512` runs the kernels at a lower dispatch level than the CPU supports.
+ */
+#include <algorithm> // std::max
+#include <cstdio>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "bench/common.hxx"
+#include "hll/dispatch.hxx"
+#include "hll/dynamic_hyper_log_log.hxx"
+#include "hll/hyper_log_log.hxx"
+
+namespace
+{
+
+constexpr std::size_t values_count = 1u << 18u;
+constexpr std::size_t repeats = 3;
+constexpr std::size_t min_k = 4;
+constexpr std::size_t max_k = 20;
+
+template<typename T, std::size_t k>
+void run_precision(const std::string& type, const std::vector<T>& values, const std::vector<T>& other_values)
+{
+    using sketch_type = hll::hyper_log_log<T, k>;
+    using hll::bench::best_seconds;
+    using hll::bench::do_not_optimize;
+    using hll::bench::report;
+
+    // large precisions do not fit into the stack
+    std::unique_ptr<sketch_type> sketch(new sketch_type{});
+    std::unique_ptr<sketch_type> other(new sketch_type{});
+    for (const auto& value : other_values)
+    {
+        other->add(value);
+    }
+
+    const auto add_seconds = best_seconds(repeats, [&]
+    {
+        sketch->clear();
+        for (const auto& value : values)
+        {
+            sketch->add(value);
+        }
+        do_not_optimize(sketch->registers());
+    });
+    report("add", type, k, add_seconds * 1e9 / values.size(), "ns/op");
+
+    const auto add_range_seconds = best_seconds(repeats, [&]
+    {
+        sketch->clear();
+        sketch->add(values.begin(), values.end());
+        do_not_optimize(sketch->registers());
+    });
+    report("add_range", type, k, add_range_seconds * 1e9 / values.size(), "ns/op");
+
+    // the same with k known only at runtime
+    hll::dynamic_hyper_log_log<T> dynamic_sketch(k);
+    const auto dynamic_add_seconds = best_seconds(repeats, [&]
+    {
+        dynamic_sketch.clear();
+        for (const auto& value : values)
+        {
+            dynamic_sketch.add(value);
+        }
+        do_not_optimize(dynamic_sketch.registers());
+    });
+    report("dynamic_add", type, k, dynamic_add_seconds * 1e9 / values.size(), "ns/op");
+
+    const auto dynamic_add_range_seconds = best_seconds(repeats, [&]
+    {
+        dynamic_sketch.clear();
+        dynamic_sketch.add(values.begin(), values.end());
+        do_not_optimize(dynamic_sketch.registers());
+    });
+    report("dynamic_add_range", type, k, dynamic_add_range_seconds * 1e9 / values.size(), "ns/op");
+
+    // the register updates alone
+    std::vector<typename sketch_type::hash_result_type> hashes;
+    hashes.reserve(values.size());
+    for (const auto& value : values)
+    {
+        hashes.push_back(typename sketch_type::hasher{}(value));
+    }
+    const auto add_hashes_seconds = best_seconds(repeats, [&]
+    {
+        sketch->clear();
+        sketch->add_hashes(hashes.data(), hashes.size());
+        do_not_optimize(sketch->registers());
+    });
+    report("add_hashes", type, k, add_hashes_seconds * 1e9 / values.size(), "ns/op");
+
+    const auto count_repeats = std::max<std::size_t>(16, (static_cast<std::size_t>(1) << 22u) >> k);
+    const auto count_seconds = best_seconds(repeats, [&]
+    {
+        for (std::size_t i = 0; i < count_repeats; ++i)
+        {
+            do_not_optimize(sketch->registers());
+            do_not_optimize(sketch->count());
+        }
+    });
+    report("count", type, k, count_seconds * 1e9 / count_repeats, "ns/op");
+
+    const auto merge_repeats = std::max<std::size_t>(16, (static_cast<std::size_t>(1) << 26u) >> k);
+    const auto merge_seconds = best_seconds(repeats, [&]
+    {
+        for (std::size_t i = 0; i < merge_repeats; ++i)
+        {
+            do_not_optimize(other->registers());
+            sketch->merge(*other);
+        }
+        do_not_optimize(sketch->registers());
+    });
+    const auto merged_bytes = static_cast<double>(merge_repeats * sizeof(typename sketch_type::container_type));
+    report("merge", type, k, merged_bytes / merge_seconds / 1e9, "GB/s");
+
+    report("memory", type, k, static_cast<double>(sizeof(sketch_type)), "bytes");
+}
+
+template<typename T, std::size_t k, std::size_t last>
+struct precision_sweep
+{
+    static void run(const std::string& type, const std::vector<T>& values, const std::vector<T>& other_values)
+    {
+        run_precision<T, k>(type, values, other_values);
+        precision_sweep<T, k + 1, last>::run(type, values, other_values);
+    }
+};
+
+template<typename T, std::size_t last>
+struct precision_sweep<T, last, last>
+{
+    static void run(const std::string& type, const std::vector<T>& values, const std::vector<T>& other_values)
+    {
+        run_precision<T, last>(type, values, other_values);
+    }
+};
+
+template<typename T>
+void run_type(const std::string& type, const hll::bench::value_generator<T>& generator)
+{
+    const auto values = hll::bench::make_values(values_count, /*seed = */ 1, generator);
+    const auto other_values = hll::bench::make_values(values_count, /*seed = */ 2, generator);
+    precision_sweep<T, min_k, max_k>::run(type, values, other_values);
+}
+
+bool parse_level(const std::string& name, hll::dispatch::level& result)
+{
+    using hll::dispatch::level;
+    for (const auto value : {level::scalar, level::sse42, level::avx2, level::avx512})
+    {
+        if (name == hll::dispatch::name(value))
+        {
+            result = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc == 3 && std::string(argv[1]) == "--level")
+    {
+        hll::dispatch::level requested;
+        if (!parse_level(argv[2], requested))
+        {
+            std::fprintf(stderr, "unknown level: %s\n", argv[2]);
+            return 1;
+        }
+        hll::dispatch::force(requested);
+    } else if (argc != 1)
+    {
+        std::fprintf(stderr, "usage: hll_benchmark [--level scalar|sse4.2|avx2|avx512]\n");
+        return 1;
+    }
+
+    std::printf("# level\t%s\n", hll::dispatch::name(hll::dispatch::active()));
+    std::printf("# benchmark\ttype\tk\tvalue\tunit\n");
+    run_type("int", hll::bench::value_generator<int>{});
+    run_type("uint64_t", hll::bench::value_generator<uint64_t>{});
+    for (const std::size_t length : {8, 32, 128})
+    {
+        run_type("string" + std::to_string(length), hll::bench::value_generator<std::string>(length));
+    }
+    return 0;
+}
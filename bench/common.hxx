@@ -0,0 +1,131 @@
+/**
+ * @file bench/common.hxx
+ * @brief Deterministic value generation and timing helpers shared by the benchmarks
+ * @author Daniil Dudkin (unterumarmung)
+ */
+#ifndef HLL_BENCH_COMMON_HXX
+#define HLL_BENCH_COMMON_HXX
+
+#include <algorithm> // std::min
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace hll
+{
+namespace bench
+{
+
+/**
+ * splitmix64 step, a bijection of the state sequence, so distinct states give distinct outputs
+ * @param state generator state, advanced
+ * @return next random value
+ */
+inline uint64_t splitmix64(uint64_t& state) noexcept
+{
+    auto z = (state += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30u)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27u)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31u);
+}
+
+/**
+ * Deterministic values of the benchmarked types
+ */
+template<typename T>
+struct value_generator
+{
+    explicit value_generator(std::size_t /* length */ = 0) noexcept
+    {
+    }
+
+    T operator()(uint64_t& state) const noexcept
+    {
+        return static_cast<T>(splitmix64(state));
+    }
+};
+
+template<>
+struct value_generator<std::string>
+{
+    explicit value_generator(std::size_t length = 16) noexcept
+            : m_length(length)
+    {
+    }
+
+    std::string operator()(uint64_t& state) const
+    {
+        std::string result(m_length, '\0');
+        uint64_t bits = 0;
+        for (std::size_t i = 0; i < m_length; ++i)
+        {
+            if (i % 8 == 0)
+                bits = splitmix64(state);
+            result[i] = static_cast<char>('a' + (bits & 0xffu) % 26);
+            bits >>= 8u;
+        }
+        return result;
+    }
+
+private:
+    std::size_t m_length;
+};
+
+template<typename T>
+std::vector<T> make_values(std::size_t count, uint64_t seed, const value_generator<T>& generator)
+{
+    std::vector<T> result;
+    result.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        result.push_back(generator(seed));
+    }
+    return result;
+}
+
+/**
+ * Keeps the compiler from optimizing away a computed value
+ */
+template<typename T>
+inline void do_not_optimize(const T& value)
+{
+#if defined(__GNUC__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+/**
+ * Runs the function several times
+ * @return the fastest run time in seconds
+ */
+template<typename F>
+double best_seconds(std::size_t repeats, F&& f)
+{
+    auto best = 1e300;
+    for (std::size_t i = 0; i < repeats; ++i)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        const auto finish = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double>(finish - start).count());
+    }
+    return best;
+}
+
+/**
+ * Prints a result line, the fields are tab-separated so outputs of two versions can be diffed and joined
+ */
+inline void report(const char* benchmark, const std::string& type, std::size_t k, double value, const char* unit)
+{
+    std::printf("%s\t%s\t%zu\t%.3f\t%s\n", benchmark, type.c_str(), k, value, unit);
+}
+
+} // namespace bench
+} // namespace hll
+
+#endif //HLL_BENCH_COMMON_HXX
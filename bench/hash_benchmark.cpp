@@ -0,0 +1,115 @@
+/**
+ * @file bench/hash_benchmark.cpp
+ * @brief Throughput and estimate quality of candidate hash functions
+ * @author Daniil Dudkin (unterumarmung)
+ *
+ * Throughput is measured on keys of 4 bytes to 4 KiB. Quality is the bias and RMSE of k = 12 and k = 14
+ * estimates for sequential integers and "key:<n>" strings, the inputs that expose weakly mixing hashes.
+ */
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include "bench/common.hxx"
+#include "bench/hashes.hxx"
+#include "hll/hyper_log_log.hxx"
+
+namespace
+{
+
+constexpr std::size_t buffer_size = 1u << 20u;
+constexpr std::size_t hashes_per_run = 1u << 20u;
+constexpr std::size_t repeats = 3;
+constexpr std::size_t trials = 16;
+
+template<typename Policy>
+void run_throughput(const char* name, const std::vector<uint8_t>& buffer)
+{
+    using hll::bench::do_not_optimize;
+    const Policy hash{};
+    for (const std::size_t length : {4, 8, 16, 32, 64, 256, 1024, 4096})
+    {
+        const auto count = std::max<std::size_t>(1024, hashes_per_run * 16 / length);
+        const auto seconds = hll::bench::best_seconds(repeats, [&]
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                // overlapping windows of the buffer, so the keys differ but stay in cache,
+                // hashed in place through a view, so only the hash is timed
+                const auto offset = (i * 61) % (buffer.size() - length);
+                const auto data = reinterpret_cast<const char*>(buffer.data()) + offset;
+                do_not_optimize(hash(hll::details::char_view<char>{data, length}));
+            }
+        });
+        std::printf("throughput\t%s\t%zu\t%.3f\tns/hash\n", name, length, seconds * 1e9 / count);
+        std::printf("throughput\t%s\t%zu\t%.3f\tGB/s\n", name, length, count * length / seconds / 1e9);
+    }
+}
+
+template<typename Policy, std::size_t k, typename T, typename MakeKey>
+void run_quality(const char* name, const char* keys, MakeKey make_key)
+{
+    using sketch_type = hll::hyper_log_log<T, k, Policy>;
+    const auto bound = 1.04 / std::sqrt(static_cast<double>(sketch_type::registers_count));
+    for (const uint64_t n : {1000, 10000, 100000, 1000000})
+    {
+        double sum = 0;
+        double squares = 0;
+        for (std::size_t trial = 0; trial < trials; ++trial)
+        {
+            std::unique_ptr<sketch_type> sketch(new sketch_type{});
+            for (uint64_t i = 0; i < n; ++i)
+            {
+                sketch->add(make_key(trial * n + i));
+            }
+            const auto error = static_cast<double>(sketch->count()) / static_cast<double>(n) - 1.0;
+            sum += error;
+            squares += error * error;
+        }
+        const auto rmse = std::sqrt(squares / trials);
+        std::printf("quality\t%s\t%s\t%zu\t%llu\t%+.5f\t%.5f\t%.3f\n", name, keys, k,
+                    static_cast<unsigned long long>(n), sum / trials, rmse, rmse / bound);
+    }
+}
+
+template<typename Policy>
+void run_hash(const char* name, const std::vector<uint8_t>& buffer)
+{
+    run_throughput<Policy>(name, buffer);
+
+    const auto integer_key = [](uint64_t i) { return i; };
+    std::string key;
+    const auto string_key = [&key](uint64_t i) -> const std::string&
+    {
+        key = "key:" + std::to_string(i);
+        return key;
+    };
+    run_quality<Policy, 12, uint64_t>(name, "sequential", integer_key);
+    run_quality<Policy, 14, uint64_t>(name, "sequential", integer_key);
+    run_quality<Policy, 12, std::string>(name, "strings", string_key);
+    run_quality<Policy, 14, std::string>(name, "strings", string_key);
+}
+
+} // namespace
+
+int main()
+{
+    std::vector<uint8_t> buffer(buffer_size);
+    uint64_t state = 1;
+    for (auto& byte : buffer)
+    {
+        byte = static_cast<uint8_t>(hll::bench::splitmix64(state));
+    }
+
+    std::printf("# throughput\thash\tkey bytes\tvalue\tunit\n");
+    std::printf("# quality\thash\tkeys\tk\tn\tbias\trmse\trmse/bound\n");
+    run_hash<hll::bench::murmur3_policy>("murmur3", buffer);
+    run_hash<hll::bench::murmur64a_policy>("murmur64a", buffer);
+    run_hash<hll::bench::xxhash64_policy>("xxhash64", buffer);
+    run_hash<hll::bench::wyhash_policy>("wyhash", buffer);
+    run_hash<hll::bench::crc32c_policy>("crc32c", buffer);
+    run_hash<hll::bench::crc32c_fmix_policy>("crc32c+fmix", buffer);
+    return 0;
+}
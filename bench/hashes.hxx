@@ -0,0 +1,251 @@
+/**
+ * @file bench/hashes.hxx
+ * @brief Candidate hash functions compared against murmurhash3 by the hash benchmark
+ * @author Daniil Dudkin (unterumarmung)
+ */
+#ifndef HLL_BENCH_HASHES_HXX
+#define HLL_BENCH_HASHES_HXX
+
+#include <cstdint>
+#include <cstring> // std::memcpy
+#include <string>
+#include <type_traits>
+#include "hll/crc32c.hxx"
+#include "hll/hash.hxx"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace hll
+{
+namespace bench
+{
+namespace details
+{
+
+inline uint64_t read64(const uint8_t* p) noexcept
+{
+    uint64_t result;
+    std::memcpy(&result, p, sizeof(result));
+    return result;
+}
+
+inline uint32_t read32(const uint8_t* p) noexcept
+{
+    uint32_t result;
+    std::memcpy(&result, p, sizeof(result));
+    return result;
+}
+
+inline uint64_t rotl(uint64_t value, uint32_t shift) noexcept
+{
+    return (value << shift) | (value >> (64 - shift));
+}
+
+constexpr uint64_t xxh_prime1 = 0x9e3779b185ebca87;
+constexpr uint64_t xxh_prime2 = 0xc2b2ae3d27d4eb4f;
+constexpr uint64_t xxh_prime3 = 0x165667b19e3779f9;
+constexpr uint64_t xxh_prime4 = 0x85ebca77c2b2ae63;
+constexpr uint64_t xxh_prime5 = 0x27d4eb2f165667c5;
+
+inline uint64_t xxh_round(uint64_t accumulator, uint64_t input) noexcept
+{
+    accumulator += input * xxh_prime2;
+    return rotl(accumulator, 31) * xxh_prime1;
+}
+
+inline uint64_t xxh_merge_round(uint64_t accumulator, uint64_t value) noexcept
+{
+    accumulator ^= xxh_round(0, value);
+    return accumulator * xxh_prime1 + xxh_prime4;
+}
+
+inline uint64_t multiply_fold(uint64_t lhs, uint64_t rhs, uint64_t& high) noexcept
+{
+#if defined(__SIZEOF_INT128__)
+    __extension__ typedef unsigned __int128 uint128;
+    const auto product = static_cast<uint128>(lhs) * rhs;
+    high = static_cast<uint64_t>(product >> 64u);
+    return static_cast<uint64_t>(product);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    return _umul128(lhs, rhs, &high);
+#else
+    const uint64_t lo_lo = (lhs & 0xffffffff) * (rhs & 0xffffffff);
+    const uint64_t hi_lo = (lhs >> 32u) * (rhs & 0xffffffff);
+    const uint64_t lo_hi = (lhs & 0xffffffff) * (rhs >> 32u);
+    const uint64_t hi_hi = (lhs >> 32u) * (rhs >> 32u);
+    const uint64_t cross = (lo_lo >> 32u) + (hi_lo & 0xffffffff) + lo_hi;
+    high = (hi_lo >> 32u) + (cross >> 32u) + hi_hi;
+    return (cross << 32u) | (lo_lo & 0xffffffff);
+#endif
+}
+
+inline uint64_t wymix(uint64_t lhs, uint64_t rhs) noexcept
+{
+    uint64_t high = 0;
+    const auto low = multiply_fold(lhs, rhs, high);
+    return low ^ high;
+}
+
+constexpr uint64_t wy_secret[4] = {0x2d358dccaa6c78a5, 0x8bb84b93962eacc9, 0x4b33a62ed433d4a3, 0x4d5a2da51de1aa47};
+
+} // namespace details
+
+/**
+ * XXH64
+ */
+inline uint64_t xxhash64(const void* key, std::size_t length, uint64_t seed) noexcept
+{
+    using namespace details;
+    auto p = static_cast<const uint8_t*>(key);
+    const auto end = p + length;
+    uint64_t h = 0;
+
+    if (length >= 32)
+    {
+        uint64_t v1 = seed + xxh_prime1 + xxh_prime2;
+        uint64_t v2 = seed + xxh_prime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - xxh_prime1;
+        do
+        {
+            v1 = xxh_round(v1, read64(p));
+            v2 = xxh_round(v2, read64(p + 8));
+            v3 = xxh_round(v3, read64(p + 16));
+            v4 = xxh_round(v4, read64(p + 24));
+            p += 32;
+        } while (end - p >= 32);
+
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = xxh_merge_round(h, v1);
+        h = xxh_merge_round(h, v2);
+        h = xxh_merge_round(h, v3);
+        h = xxh_merge_round(h, v4);
+    } else
+    {
+        h = seed + xxh_prime5;
+    }
+
+    h += length;
+    for (; end - p >= 8; p += 8)
+    {
+        h ^= xxh_round(0, read64(p));
+        h = rotl(h, 27) * xxh_prime1 + xxh_prime4;
+    }
+    if (end - p >= 4)
+    {
+        h ^= static_cast<uint64_t>(read32(p)) * xxh_prime1;
+        h = rotl(h, 23) * xxh_prime2 + xxh_prime3;
+        p += 4;
+    }
+    for (; p != end; ++p)
+    {
+        h ^= *p * xxh_prime5;
+        h = rotl(h, 11) * xxh_prime1;
+    }
+
+    h ^= h >> 33u;
+    h *= xxh_prime2;
+    h ^= h >> 29u;
+    h *= xxh_prime3;
+    h ^= h >> 32u;
+    return h;
+}
+
+/**
+ * wyhash, final version 4 construction
+ */
+inline uint64_t wyhash(const void* key, std::size_t length, uint64_t seed) noexcept
+{
+    using namespace details;
+    auto p = static_cast<const uint8_t*>(key);
+    seed ^= wymix(seed ^ wy_secret[0], wy_secret[1]);
+    uint64_t a = 0;
+    uint64_t b = 0;
+    if (length <= 16)
+    {
+        if (length >= 4)
+        {
+            const auto middle = (length >> 3u) << 2u;
+            a = (static_cast<uint64_t>(read32(p)) << 32u) | read32(p + middle);
+            b = (static_cast<uint64_t>(read32(p + length - 4)) << 32u) | read32(p + length - 4 - middle);
+        } else if (length > 0)
+        {
+            a = (static_cast<uint64_t>(p[0]) << 16u) | (static_cast<uint64_t>(p[length >> 1u]) << 8u) | p[length - 1];
+        }
+    } else
+    {
+        auto i = length;
+        if (i > 48)
+        {
+            auto see1 = seed;
+            auto see2 = seed;
+            do
+            {
+                seed = wymix(read64(p) ^ wy_secret[1], read64(p + 8) ^ seed);
+                see1 = wymix(read64(p + 16) ^ wy_secret[2], read64(p + 24) ^ see1);
+                see2 = wymix(read64(p + 32) ^ wy_secret[3], read64(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16)
+        {
+            seed = wymix(read64(p) ^ wy_secret[1], read64(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = read64(p + i - 16);
+        b = read64(p + i - 8);
+    }
+
+    a ^= wy_secret[1];
+    b ^= seed;
+    a = multiply_fold(a, b, b);
+    return wymix(a ^ wy_secret[0] ^ length, b ^ wy_secret[1]);
+}
+
+/**
+ * Adapts a byte hash function into a hyper_log_log hash policy for fundamentals and contiguous containers
+ */
+template<typename Result, Result (* Function)(const void*, std::size_t, Result)>
+struct byte_hash
+{
+    using result_type = Result;
+
+    template<typename T, typename std::enable_if<std::is_fundamental<T>::value>::type* = nullptr>
+    result_type operator()(const T& value) const noexcept
+    {
+        return Function(&value, sizeof(T), 0);
+    }
+
+    template<typename T, typename std::enable_if<hll::traits::is_ra_fundamental_container<T>::value>::type* = nullptr>
+    result_type operator()(const T& value) const noexcept
+    {
+        return Function(value.data(), value.size() * sizeof(typename T::value_type), 0);
+    }
+};
+
+inline uint32_t murmur3_bytes(const void* key, std::size_t length, uint32_t seed) noexcept
+{
+    return murmur_hash(key, static_cast<uint32_t>(length), seed);
+}
+
+inline uint64_t murmur64a_bytes(const void* key, std::size_t length, uint64_t seed) noexcept
+{
+    return murmur_hash64a(key, length, seed);
+}
+
+using murmur3_policy = byte_hash<uint32_t, murmur3_bytes>;
+using murmur64a_policy = byte_hash<uint64_t, murmur64a_bytes>;
+using xxhash64_policy = byte_hash<uint64_t, xxhash64>;
+using wyhash_policy = byte_hash<uint64_t, wyhash>;
+using crc32c_policy = byte_hash<uint32_t, hll::crc32c>;
+using crc32c_fmix_policy = hll::crc32c_hash;
+
+} // namespace bench
+} // namespace hll
+
+#endif //HLL_BENCH_HASHES_HXX
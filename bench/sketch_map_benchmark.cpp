@@ -0,0 +1,168 @@
+/**
+ * @file bench/sketch_map_benchmark.cpp
+ * @brief Speed of COUNT(DISTINCT value) GROUP BY key: concurrent_sketch_map against a mutex-guarded unordered_map
+ * @author Daniil Dudkin (unterumarmung)
+ *
+ * Rows are (key, value) pairs with a skewed key distribution: a few keys get most of the rows
+ * and most keys get a few, as group-by keys usually do. Every thread adds its share of the rows,
+ * then all the counts are taken. The output is one tab-separated line per measurement:
+ * benchmark, map, threads, value, unit. `--threads N` sets the largest number of threads.
+ */
+#include <algorithm> // std::max, std::min
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "bench/common.hxx"
+#include "hll/concurrent_sketch_map.hxx"
+
+namespace
+{
+
+constexpr std::size_t k = 12;
+constexpr std::size_t rows_count = 1u << 22u;
+constexpr std::size_t max_key_bits = 17;
+constexpr std::size_t repeats = 3;
+
+using sketch_type = hll::hyper_log_log<uint64_t, k>;
+
+struct row
+{
+    uint64_t key;
+    uint64_t value;
+};
+
+/// keys are log-uniform: key bits are uniform, so key 0 gets as many rows as all keys of 17 bits together
+std::vector<row> make_rows()
+{
+    std::vector<row> result;
+    result.reserve(rows_count);
+    uint64_t state = 1;
+    for (std::size_t i = 0; i < rows_count; ++i)
+    {
+        const auto bits = hll::bench::splitmix64(state) % (max_key_bits + 1);
+        const auto key = hll::bench::splitmix64(state) & ((static_cast<uint64_t>(1) << bits) - 1);
+        result.push_back(row{key, hll::bench::splitmix64(state) % (1u << 20u)});
+    }
+    return result;
+}
+
+/// what the map replaces: one lock for the whole map and a dense sketch per key
+class naive_map
+{
+public:
+    void add(uint64_t key, uint64_t value)
+    {
+        const auto hash = sketch_type::hasher{}(value);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_sketches[key].add_hash(hash);
+    }
+
+    std::size_t count_all() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::size_t result = 0;
+        for (const auto& item : m_sketches)
+        {
+            result += item.second.count();
+        }
+        return result;
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    std::unordered_map<uint64_t, sketch_type> m_sketches;
+};
+
+class striped_map
+{
+public:
+    void add(uint64_t key, uint64_t value)
+    {
+        m_sketches.add(key, value);
+    }
+
+    std::size_t count_all() const
+    {
+        std::size_t result = 0;
+        m_sketches.for_each([&result](uint64_t, std::size_t count)
+        {
+            result += count;
+        });
+        return result;
+    }
+
+private:
+    hll::concurrent_sketch_map<uint64_t, uint64_t, k> m_sketches;
+};
+
+template<typename Map>
+void run_map(const char* name, const std::vector<row>& rows, std::size_t threads)
+{
+    using hll::bench::best_seconds;
+    using hll::bench::do_not_optimize;
+
+    std::unique_ptr<Map> map;
+    const auto add_seconds = best_seconds(repeats, [&]
+    {
+        map.reset(new Map());
+        std::vector<std::thread> workers;
+        const auto share = (rows.size() + threads - 1) / threads;
+        for (std::size_t t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&map, &rows, share, t]
+            {
+                const auto last = std::min(rows.size(), (t + 1) * share);
+                for (auto i = t * share; i < last; ++i)
+                {
+                    map->add(rows[i].key, rows[i].value);
+                }
+            });
+        }
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+    });
+    std::printf("add\t%s\t%zu\t%.3f\tns/row\n", name, threads, add_seconds * 1e9 / rows.size());
+
+    std::size_t total = 0;
+    const auto count_seconds = best_seconds(repeats, [&]
+    {
+        total = map->count_all();
+        do_not_optimize(total);
+    });
+    std::printf("count_all\t%s\t%zu\t%.3f\tms\n", name, threads, count_seconds * 1e3);
+    std::printf("total\t%s\t%zu\t%zu\tcount\n", name, threads, total);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            max_threads = std::max(1, std::atoi(argv[++i]));
+        } else
+        {
+            std::fprintf(stderr, "usage: %s [--threads N]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    const auto rows = make_rows();
+    for (std::size_t threads = 1; threads <= max_threads; threads *= 2)
+    {
+        run_map<naive_map>("naive", rows, threads);
+        run_map<striped_map>("striped", rows, threads);
+    }
+    return 0;
+}
@@ -0,0 +1,150 @@
+/**
+ * @file bench/sliding_benchmark.cpp
+ * @brief Exactness and query speed of sliding_hyper_log_log against per-second hyper_log_log sketches
+ * @author Daniil Dudkin (unterumarmung)
+ *
+ * A stream of values with timestamps, one tick per second, is added to a sliding sketch. The check compares
+ * the registers of every queried window with a hyper_log_log of exactly the values added inside it, also for
+ * a sketch merged from two halves of the stream and for one fed in reverse order, and exits with 1 on a mismatch.
+ * The benchmark compares a 5-minute query with merging a ring of 300 one-second sketches.
+ * The output is one tab-separated line per measurement: benchmark, sketch, window, value, unit.
+ */
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include "bench/common.hxx"
+#include "hll/sliding_hyper_log_log.hxx"
+
+namespace
+{
+
+constexpr std::size_t k = 12;
+constexpr uint64_t max_window = 300;
+constexpr uint64_t ticks = 1000;
+constexpr std::size_t values_per_tick = 500;
+constexpr std::size_t queries = 200;
+constexpr std::size_t repeats = 3;
+
+using sketch_type = hll::hyper_log_log<uint64_t, k>;
+using sliding_type = hll::sliding_hyper_log_log<uint64_t, k>;
+
+struct event
+{
+    uint64_t timestamp;
+    uint64_t value;
+};
+
+/// values repeat within and across the ticks, as users of a site do
+std::vector<event> make_events()
+{
+    std::vector<event> result;
+    result.reserve(ticks * values_per_tick);
+    uint64_t state = 1;
+    for (uint64_t timestamp = 0; timestamp < ticks; ++timestamp)
+    {
+        for (std::size_t i = 0; i < values_per_tick; ++i)
+        {
+            result.push_back(event{timestamp, hll::bench::splitmix64(state) % 200000});
+        }
+    }
+    return result;
+}
+
+sketch_type exact_window(const std::vector<event>& events, uint64_t window, uint64_t now)
+{
+    sketch_type result{};
+    for (const auto& e : events)
+    {
+        if (e.timestamp <= now && e.timestamp + window > now)
+            result.add(e.value);
+    }
+    return result;
+}
+
+bool check(const char* name, const sliding_type& sliding, const std::vector<event>& events)
+{
+    const auto now = ticks - 1;
+    auto matches = true;
+    for (const uint64_t window : {uint64_t{1}, uint64_t{10}, uint64_t{60}, max_window})
+    {
+        const auto expected = exact_window(events, window, now);
+        const auto same = sliding.sketch(window, now).registers() == expected.registers()
+                          && sliding.count(window, now) == expected.count();
+        std::printf("check\t%s\t%llu\t%zu\t%s\n", name, static_cast<unsigned long long>(window),
+                    sliding.count(window, now), same ? "ok" : "mismatch");
+        matches = matches && same;
+    }
+    // a window ending before the latest value is lost, it must not be answered by the later values
+    const auto past = sliding.count(10, now - 100) == 0;
+    std::printf("check\t%s\tpast\t%zu\t%s\n", name, sliding.count(10, now - 100), past ? "ok" : "mismatch");
+    return matches && past;
+}
+
+void run_query(const std::vector<event>& events)
+{
+    using hll::bench::best_seconds;
+    using hll::bench::do_not_optimize;
+
+    sliding_type sliding(max_window);
+    std::vector<sketch_type> ring(max_window);
+    for (const auto& e : events)
+    {
+        sliding.add(e.value, e.timestamp);
+        ring[e.timestamp % max_window].add(e.value);
+    }
+
+    const auto ring_seconds = best_seconds(repeats, [&]
+    {
+        for (std::size_t q = 0; q < queries; ++q)
+        {
+            sketch_type merged{};
+            for (const auto& sketch : ring)
+            {
+                merged.merge(sketch);
+            }
+            do_not_optimize(merged.count());
+        }
+    });
+    std::printf("query\tring\t%llu\t%.3f\tus\n", static_cast<unsigned long long>(max_window),
+                ring_seconds * 1e6 / queries);
+
+    const auto sliding_seconds = best_seconds(repeats, [&]
+    {
+        for (std::size_t q = 0; q < queries; ++q)
+        {
+            do_not_optimize(sliding.count(max_window, ticks - 1));
+        }
+    });
+    std::printf("query\tsliding\t%llu\t%.3f\tus\n", static_cast<unsigned long long>(max_window),
+                sliding_seconds * 1e6 / queries);
+}
+
+} // namespace
+
+int main()
+{
+    const auto events = make_events();
+
+    sliding_type in_order(max_window);
+    sliding_type even(max_window);
+    sliding_type odd(max_window);
+    for (std::size_t i = 0; i < events.size(); ++i)
+    {
+        in_order.add(events[i].value, events[i].timestamp);
+        (i % 2 == 0 ? even : odd).add(events[i].value, events[i].timestamp);
+    }
+    even.merge(odd);
+
+    sliding_type reversed(max_window);
+    for (auto i = events.size(); i-- > 0;)
+    {
+        reversed.add(events[i].value, events[i].timestamp);
+    }
+
+    auto matches = check("in_order", in_order, events);
+    matches = check("merged", even, events) && matches;
+    matches = check("reversed", reversed, events) && matches;
+
+    run_query(events);
+    return matches ? 0 : 1;
+}
@@ -0,0 +1,441 @@
+/**
+ * @file hll/compression.hxx
+ * @brief Entropy-coded serialization of the registers for cold storage
+ * @author Daniil Dudkin (unterumarmung)
+ *
+ * Register values of a dense sketch concentrate around log2(n/m), so their entropy is about 3 bits.
+ * The registers are coded with rANS using a quantized histogram of the sketch itself.
+ * Layout: precision (1 byte), alphabet size A (1 byte), A frequencies as LEB128 varints,
+ * final rANS state (4 bytes, little-endian) and the rANS byte stream.
+ */
+#ifndef HLL_COMPRESSION_HXX
+#define HLL_COMPRESSION_HXX
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "dynamic_hyper_log_log.hxx"
+#include "hyper_log_log.hxx"
+#include "sketch_bank.hxx"
+
+namespace hll
+{
+namespace compression
+{
+namespace details
+{
+
+/// the largest register value is 64 - 4 + 1 for 64-bit hashes
+constexpr std::size_t max_alphabet_size = 64;
+constexpr uint32_t scale_bits = 12;
+constexpr uint32_t total_frequency = 1u << scale_bits;
+/// lower bound of the rANS state
+constexpr uint32_t rans_low = 1u << 23;
+
+using frequency_table = std::array<uint32_t, max_alphabet_size>;
+
+inline std::size_t log2_exact(std::size_t count) noexcept
+{
+    std::size_t result = 0;
+    while ((static_cast<std::size_t>(1) << result) < count)
+        ++result;
+    return result;
+}
+
+/**
+ * Scales the histogram so it sums up to total_frequency, keeping every present symbol encodable
+ */
+inline void quantize(const std::array<std::size_t, max_alphabet_size>& histogram, std::size_t alphabet_size,
+                     std::size_t count, frequency_table& frequencies) noexcept
+{
+    uint32_t sum = 0;
+    std::size_t largest = 0;
+    for (std::size_t s = 0; s < alphabet_size; ++s)
+    {
+        frequencies[s] = 0;
+        if (histogram[s] != 0)
+        {
+            const auto scaled = static_cast<uint32_t>((histogram[s] * total_frequency + count / 2) / count);
+            frequencies[s] = scaled == 0 ? 1 : scaled;
+        }
+        sum += frequencies[s];
+        if (frequencies[s] > frequencies[largest])
+            largest = s;
+    }
+
+    if (sum <= total_frequency)
+    {
+        frequencies[largest] += total_frequency - sum;
+        return;
+    }
+
+    // rounding up the rare symbols overshot the total, take the excess from the most frequent ones
+    while (sum > total_frequency)
+    {
+        for (std::size_t s = 0; s < alphabet_size; ++s)
+        {
+            if (frequencies[s] > frequencies[largest])
+                largest = s;
+        }
+        const auto excess = std::min(sum - total_frequency, frequencies[largest] / 2);
+        frequencies[largest] -= excess;
+        sum -= excess;
+    }
+}
+
+inline void write_varint(std::vector<uint8_t>& out, uint32_t value)
+{
+    while (value >= 0x80u)
+    {
+        out.push_back(static_cast<uint8_t>(value | 0x80u));
+        value >>= 7u;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+inline bool read_varint(const uint8_t*& data, const uint8_t* end, uint32_t& value) noexcept
+{
+    value = 0;
+    for (uint32_t shift = 0; shift < 32; shift += 7)
+    {
+        if (data == end)
+            return false;
+        const auto byte = *data++;
+        value |= static_cast<uint32_t>(byte & 0x7fu) << shift;
+        if ((byte & 0x80u) == 0)
+            return true;
+    }
+    return false;
+}
+
+inline std::vector<uint8_t> encode_registers(const int8_t* registers, std::size_t count)
+{
+    std::array<std::size_t, max_alphabet_size> histogram{};
+    std::size_t alphabet_size = 1;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const auto value = static_cast<std::size_t>(registers[i]);
+        ++histogram[value];
+        alphabet_size = std::max(alphabet_size, value + 1);
+    }
+
+    frequency_table frequencies{};
+    frequency_table cumulative{};
+    quantize(histogram, alphabet_size, count, frequencies);
+    for (std::size_t s = 1; s < alphabet_size; ++s)
+    {
+        cumulative[s] = cumulative[s - 1] + frequencies[s - 1];
+    }
+
+    // rANS is LIFO: encode backwards into the end of the buffer so the decoder reads forwards
+    std::vector<uint8_t> stream(count * scale_bits / 8 + 16);
+    auto position = stream.size();
+    uint32_t state = rans_low;
+    for (std::size_t i = count; i-- > 0;)
+    {
+        const auto symbol = static_cast<std::size_t>(registers[i]);
+        const auto frequency = frequencies[symbol];
+        const auto state_max = ((rans_low >> scale_bits) << 8u) * frequency;
+        while (state >= state_max)
+        {
+            stream[--position] = static_cast<uint8_t>(state & 0xffu);
+            state >>= 8u;
+        }
+        state = ((state / frequency) << scale_bits) + (state % frequency) + cumulative[symbol];
+    }
+
+    std::vector<uint8_t> result;
+    result.reserve(2 + alphabet_size * 2 + 4 + stream.size() - position);
+    result.push_back(static_cast<uint8_t>(log2_exact(count)));
+    result.push_back(static_cast<uint8_t>(alphabet_size));
+    for (std::size_t s = 0; s < alphabet_size; ++s)
+    {
+        write_varint(result, frequencies[s]);
+    }
+    for (uint32_t shift = 0; shift < 32; shift += 8)
+    {
+        result.push_back(static_cast<uint8_t>(state >> shift));
+    }
+    result.insert(result.end(), stream.begin() + static_cast<std::ptrdiff_t>(position), stream.end());
+    return result;
+}
+
+/// the fields of serialized registers that precede the rANS byte stream
+struct registers_header
+{
+    std::size_t precision;
+    frequency_table frequencies;
+    frequency_table cumulative;
+    uint32_t state;
+};
+
+/**
+ * Reads and validates the header of serialized registers, touching nothing but the data
+ * @param bytes serialized registers, advanced past the header
+ * @param end the end of the serialized registers
+ * @param header the result
+ * @return false if the header is malformed
+ */
+inline bool read_header(const uint8_t*& bytes, const uint8_t* end, registers_header& header) noexcept
+{
+    if (end - bytes < 2 || bytes[1] == 0 || bytes[1] > max_alphabet_size)
+        return false;
+
+    header.precision = bytes[0];
+    const std::size_t alphabet_size = bytes[1];
+    bytes += 2;
+
+    header.frequencies.fill(0);
+    header.cumulative.fill(0);
+    uint32_t sum = 0;
+    for (std::size_t s = 0; s < alphabet_size; ++s)
+    {
+        auto& frequency = header.frequencies[s];
+        if (!read_varint(bytes, end, frequency) || frequency > total_frequency - sum)
+            return false;
+        header.cumulative[s] = sum;
+        sum += frequency;
+    }
+    if (sum != total_frequency || end - bytes < 4)
+        return false;
+
+    header.state = 0;
+    for (uint32_t shift = 0; shift < 32; shift += 8)
+    {
+        header.state |= static_cast<uint32_t>(*bytes++) << shift;
+    }
+    // the encoder keeps its state in [rans_low; rans_low * 256)
+    return header.state >= rans_low && header.state < (rans_low << 8u);
+}
+
+/**
+ * Decodes the registers passing every one of them to the sink
+ * @param sink a function object called as sink(index, value)
+ * @return false if the data is malformed or was produced for a different number of registers
+ */
+template<typename Sink>
+bool decode_registers(const void* data, std::size_t size, std::size_t count, Sink sink)
+{
+    auto bytes = static_cast<const uint8_t*>(data);
+    const auto end = bytes + size;
+    registers_header header;
+    if (!read_header(bytes, end, header) || header.precision != log2_exact(count))
+        return false;
+
+    const auto& frequencies = header.frequencies;
+    const auto& cumulative = header.cumulative;
+    std::array<uint8_t, total_frequency> symbols{};
+    for (std::size_t s = 0; s < max_alphabet_size; ++s)
+    {
+        for (uint32_t slot = cumulative[s]; slot < cumulative[s] + frequencies[s]; ++slot)
+        {
+            symbols[slot] = static_cast<uint8_t>(s);
+        }
+    }
+
+    auto state = header.state;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const auto slot = state & (total_frequency - 1);
+        const auto symbol = symbols[slot];
+        sink(i, symbol);
+        state = frequencies[symbol] * (state >> scale_bits) + slot - cumulative[symbol];
+        while (state < rans_low)
+        {
+            if (bytes == end)
+                return false;
+            state = (state << 8u) | *bytes++;
+        }
+    }
+
+    // the encoder started from rans_low, so a well-formed stream ends exactly there
+    return state == rans_low && bytes == end;
+}
+
+} // namespace details
+
+/**
+ * Serializes a sketch with entropy-coded registers
+ * @param source the sketch
+ * @return serialized sketch
+ */
+template<typename T, std::size_t k, typename Hash>
+std::vector<uint8_t> encode(const hyper_log_log<T, k, Hash>& source)
+{
+    return details::encode_registers(source.registers().data(), source.registers().size());
+}
+
+/**
+ * Deserializes a sketch serialized by encode, replacing its registers
+ * @param data serialized sketch
+ * @param size serialized sketch length
+ * @param target the sketch to load into
+ * @return false if the data is malformed or has a different precision, the sketch is left unspecified then
+ */
+template<typename T, std::size_t k, typename Hash>
+bool decode(const void* data, std::size_t size, hyper_log_log<T, k, Hash>& target)
+{
+    auto& registers = target.registers();
+    return details::decode_registers(data, size, registers.size(), [&registers](std::size_t index, uint8_t value)
+    {
+        registers[index] = static_cast<int8_t>(value);
+    });
+}
+
+/**
+ * Merges a sketch serialized by encode into the target without materializing a temporary sketch
+ * @param data serialized sketch
+ * @param size serialized sketch length
+ * @param target the sketch to merge into
+ * @return false if the data is malformed or has a different precision, the sketch is left unspecified then
+ */
+template<typename T, std::size_t k, typename Hash>
+bool merge(const void* data, std::size_t size, hyper_log_log<T, k, Hash>& target)
+{
+    auto& registers = target.registers();
+    return details::decode_registers(data, size, registers.size(), [&registers](std::size_t index, uint8_t value)
+    {
+        registers[index] = std::max(registers[index], static_cast<int8_t>(value));
+    });
+}
+
+/**
+ * Serializes a sketch with entropy-coded registers, the format is the same as of a sketch of a compile-time precision
+ * @param source the sketch
+ * @return serialized sketch
+ */
+template<typename T, typename Hash, typename Allocator>
+std::vector<uint8_t> encode(const dynamic_hyper_log_log<T, Hash, Allocator>& source)
+{
+    return details::encode_registers(source.registers().data(), source.registers().size());
+}
+
+/**
+ * Deserializes a sketch serialized by encode, taking the precision of the serialized sketch.
+ * The header is validated before the target is resized, but a well-formed header alone decides the precision:
+ * as equal registers take a few bytes, untrusted data of a dozen bytes can make the target allocate 2^30 registers,
+ * check the first byte, the precision, against a limit before decoding such data
+ * @param data serialized sketch
+ * @param size serialized sketch length
+ * @param target the sketch to load into
+ * @return false if the data is malformed, the sketch is left unspecified then
+ */
+template<typename T, typename Hash, typename Allocator>
+bool decode(const void* data, std::size_t size, dynamic_hyper_log_log<T, Hash, Allocator>& target)
+{
+    using sketch_type = dynamic_hyper_log_log<T, Hash, Allocator>;
+    auto bytes = static_cast<const uint8_t*>(data);
+    details::registers_header header;
+    if (!details::read_header(bytes, bytes + size, header)
+        || header.precision < sketch_type::min_precision || header.precision > sketch_type::max_precision)
+        return false;
+    if (header.precision != target.precision())
+        target = sketch_type(header.precision, target.get_allocator());
+
+    auto& registers = target.registers();
+    return details::decode_registers(data, size, registers.size(), [&registers](std::size_t index, uint8_t value)
+    {
+        registers[index] = static_cast<int8_t>(value);
+    });
+}
+
+/**
+ * Merges a sketch serialized by encode into the target without materializing a temporary sketch
+ * @param data serialized sketch
+ * @param size serialized sketch length
+ * @param target the sketch to merge into
+ * @return false if the data is malformed or has a different precision, the sketch is left unspecified then
+ */
+template<typename T, typename Hash, typename Allocator>
+bool merge(const void* data, std::size_t size, dynamic_hyper_log_log<T, Hash, Allocator>& target)
+{
+    auto& registers = target.registers();
+    return details::decode_registers(data, size, registers.size(), [&registers](std::size_t index, uint8_t value)
+    {
+        registers[index] = std::max(registers[index], static_cast<int8_t>(value));
+    });
+}
+
+/**
+ * Serializes all the sketches of the bank keeping their handles.
+ * Layout: number of the handles as a LEB128 varint, then for every handle the length of the serialized sketch
+ * as a varint and the sketch serialized by encode, zero length for a released handle
+ * @param source the bank
+ * @return serialized bank
+ */
+template<typename T, std::size_t k, typename Hash>
+std::vector<uint8_t> encode(const sketch_bank<T, k, Hash>& source)
+{
+    using bank_type = sketch_bank<T, k, Hash>;
+    std::vector<uint8_t> result;
+    details::write_varint(result, static_cast<uint32_t>(source.slots()));
+    for (std::size_t i = 0; i < source.slots(); ++i)
+    {
+        const auto handle = static_cast<typename bank_type::handle_type>(i);
+        if (!source.contains(handle))
+        {
+            details::write_varint(result, 0);
+            continue;
+        }
+        const auto sketch = details::encode_registers(source.registers(handle), bank_type::registers_count);
+        details::write_varint(result, static_cast<uint32_t>(sketch.size()));
+        result.insert(result.end(), sketch.begin(), sketch.end());
+    }
+    return result;
+}
+
+/**
+ * Deserializes a bank serialized by encode, replacing its sketches. The sketches get the same handles
+ * @param data serialized bank
+ * @param size serialized bank length
+ * @param target the bank to load into
+ * @return false if the data is malformed or has a different precision, the bank is left unspecified then
+ */
+template<typename T, std::size_t k, typename Hash>
+bool decode(const void* data, std::size_t size, sketch_bank<T, k, Hash>& target)
+{
+    using bank_type = sketch_bank<T, k, Hash>;
+    auto bytes = static_cast<const uint8_t*>(data);
+    const auto end = bytes + size;
+    target.clear();
+
+    uint32_t slots = 0;
+    // every handle takes at least a byte
+    if (!details::read_varint(bytes, end, slots) || slots > static_cast<std::size_t>(end - bytes))
+        return false;
+
+    std::vector<typename bank_type::handle_type> released;
+    for (uint32_t i = 0; i < slots; ++i)
+    {
+        uint32_t length = 0;
+        if (!details::read_varint(bytes, end, length) || length > static_cast<std::size_t>(end - bytes))
+            return false;
+
+        const auto handle = target.create();
+        if (length == 0)
+        {
+            released.push_back(handle);
+            continue;
+        }
+        const auto registers = target.registers(handle);
+        if (!details::decode_registers(bytes, length, bank_type::registers_count,
+                                       [registers](std::size_t index, uint8_t value)
+                                       {
+                                           registers[index] = static_cast<int8_t>(value);
+                                       }))
+            return false;
+        bytes += length;
+    }
+
+    // create hands out the lowest released handle first
+    for (auto it = released.rbegin(); it != released.rend(); ++it)
+    {
+        target.release(*it);
+    }
+    return bytes == end;
+}
+
+} // namespace compression
+} // namespace hll
+
+#endif //HLL_COMPRESSION_HXX
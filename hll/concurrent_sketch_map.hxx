@@ -0,0 +1,418 @@
+/**
+ * @file hll/concurrent_sketch_map.hxx
+ * @brief Thread-safe map from keys to sketches, for COUNT(DISTINCT value) GROUP BY key
+ * @author Daniil Dudkin (unterumarmung)
+ */
+#ifndef HLL_CONCURRENT_SKETCH_MAP_HXX
+#define HLL_CONCURRENT_SKETCH_MAP_HXX
+
+#include <algorithm> // std::lower_bound, std::fill, std::copy
+#include <cmath> // std::ldexp
+#include <cstdint>
+#include <functional> // std::hash, std::equal_to
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <utility> // std::move, std::pair
+#include <vector>
+#include "hyper_log_log.hxx"
+#include "slab.hxx"
+
+namespace hll
+{
+/**
+ * @brief Thread-safe map from keys to sketches of values, e.g. to answer COUNT(DISTINCT user) GROUP BY key.
+ * Keys are spread over stripes, each guarded by its own mutex, so threads adding to different keys rarely wait
+ * for each other. Values are hashed before taking the lock. A key's sketch starts sparse, as a sorted list of its
+ * non-zero registers, and gets all 2^k registers when the list grows past sparse_max, so the many keys with
+ * few values take a fraction of a sketch. Both come from a slab of the stripe, so erased keys' memory is reused.
+ * Counts are equal to the ones of hyper_log_log<T, k, Hash> with the same values: a sparse sketch always estimates
+ * by linear counting, which depends on the number of the zero registers only
+ * @tparam Key the type of keys
+ * @tparam T the type of values
+ * @tparam k number that controls number of registers as 2^k
+ * @tparam Hash hash policy of values, as in hyper_log_log
+ * @tparam KeyHash hash function of keys
+ * @tparam KeyEqual equality of keys
+ */
+template<typename Key, typename T, std::size_t k, typename Hash = hll::murmur3_hash,
+        typename KeyHash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class concurrent_sketch_map
+{
+public:
+    using key_type = Key;
+    using value_type = T;
+    using hasher = Hash;
+    using hash_result_type = typename Hash::result_type;
+    /// type of registers of the sketches
+    using register_type = int8_t;
+    /// type of size values
+    using size_type = size_t;
+    /// a sketch of a key, to take out or merge in
+    using sketch_type = hyper_log_log<T, k, Hash>;
+    static constexpr size_type registers_count = sketch_type::registers_count;
+    /// number of bits of the hash values
+    static constexpr size_type hash_bits = sketch_type::hash_bits;
+
+private:
+    /// a non-zero register as index << rank_bits | value, the value is at most 64 - 4 + 1
+    using sparse_register = typename std::conditional<k + 6 <= 32, uint32_t, uint64_t>::type;
+    static constexpr unsigned rank_bits = 6;
+
+public:
+    /// number of the non-zero registers a sparse sketch keeps, it takes half of the dense registers' memory then
+    static constexpr size_type sparse_max = registers_count / (2 * sizeof(sparse_register));
+
+private:
+    using sparse_container = std::vector<sparse_register, hll::slab_allocator<sparse_register>>;
+
+    struct entry
+    {
+        explicit entry(hll::slab& memory)
+                : sparse(hll::slab_allocator<sparse_register>(memory))
+        {
+        }
+
+        /// non-zero registers sorted by index while the sketch is sparse
+        sparse_container sparse;
+        /// all the registers once the sketch is dense
+        register_type* dense = nullptr;
+    };
+
+    struct stripe
+    {
+        mutable std::mutex mutex;
+        /// declared before the entries to outlive them
+        hll::slab memory;
+        std::unordered_map<Key, entry, KeyHash, KeyEqual> entries;
+    };
+
+    std::vector<std::unique_ptr<stripe>> m_stripes;
+    size_type m_stripe_mask = 0;
+    KeyHash m_key_hash;
+
+    stripe& stripe_of(const Key& key) const
+    {
+        // unordered_map takes the low bits of the key hash, so the stripe takes the high bits of its remix
+        const auto mixed = static_cast<uint64_t>(m_key_hash(key)) * 0x9e3779b97f4a7c15u;
+        return *m_stripes[static_cast<size_type>(mixed >> 32u) & m_stripe_mask];
+    }
+
+    static entry& find_or_create(stripe& owner, const Key& key);
+
+    static void make_dense(stripe& owner, entry& sketch);
+
+    static void update(stripe& owner, entry& sketch, uint32_t index, uint32_t rank);
+
+    static size_type estimate(const entry& sketch);
+
+public:
+    /**
+     * Construct an empty map
+     * @param stripes number of the independently locked parts of the map, rounded up to a power of two.
+     * A few times the number of the adding threads keeps them from waiting for each other
+     */
+    explicit concurrent_sketch_map(size_type stripes = 64);
+
+    /**
+     * Add a value to the sketch of the key, creating the sketch if there is none
+     * @param key the key
+     * @param value the value
+     */
+    void add(const Key& key, const value_type& value)
+    {
+        add_hash(key, Hash{}(value));
+    }
+
+    /**
+     * Add values to the sketch of the key, hashing them in blocks and locking once per block
+     * @param key the key
+     * @param first the first value
+     * @param last past the last value
+     */
+    template<typename InputIt>
+    void add(const Key& key, InputIt first, InputIt last);
+
+    /**
+     * Add a value to the sketch of the key by its hash
+     * @param key the key
+     * @param hash_value the hash of the value
+     */
+    void add_hash(const Key& key, hash_result_type hash_value);
+
+    /**
+     * Get unique values count of the key
+     * @param key the key
+     * @return the count, zero if the key has no sketch
+     */
+    size_type count(const Key& key) const;
+
+    /**
+     * Copy the sketch of the key out of the map
+     * @param key the key
+     * @return the sketch, empty if the key has none
+     */
+    sketch_type sketch(const Key& key) const;
+
+    /**
+     * Merge a sketch into the sketch of the key, creating the sketch if there is none
+     * @param key the key
+     * @param rhs the sketch to merge
+     */
+    void merge(const Key& key, const sketch_type& rhs);
+
+    /**
+     * Remove the sketch of the key
+     * @param key the key
+     * @return false if the key has no sketch
+     */
+    bool erase(const Key& key);
+
+    /**
+     * Get number of the keys
+     * @return the number, the keys added or erased meanwhile may be counted or not
+     */
+    size_type size() const;
+
+    /**
+     * Remove all the sketches and free their memory
+     */
+    void clear();
+
+    /**
+     * Call fn(key, count) for every key, locking one stripe at a time: the keys of a stripe are seen at one moment,
+     * the keys of different stripes are not. fn must not call into the map
+     * @param fn the function object
+     */
+    template<typename Fn>
+    void for_each(Fn fn) const;
+
+    /**
+     * Get counts of all the keys
+     * @return key and count pairs in an unspecified order, seen as for_each sees them
+     */
+    std::vector<std::pair<Key, size_type>> snapshot() const;
+};
+
+template<typename Key, typename T, std::size_t k, typename Hash, typename KeyHash, typename KeyEqual>
+concurrent_sketch_map<Key, T, k, Hash, KeyHash, KeyEqual>::concurrent_sketch_map(size_type stripes)
+{
+    size_type count = 1;
+    while (count < stripes)
+        count <<= 1u;
+    m_stripe_mask = count - 1;
+    m_stripes.reserve(count);
+    for (size_type i = 0; i < count; ++i)
+    {
+        m_stripes.emplace_back(new stripe());
+    }
+}
+
+template<typename Key, typename T, std::size_t k, typename Hash, typename KeyHash, typename KeyEqual>
+auto concurrent_sketch_map<Key, T, k, Hash, KeyHash, KeyEqual>::find_or_create(stripe& owner, const Key& key)
+-> entry&
+{
+    auto it = owner.entries.find(key);
+    if (it == owner.entries.end())
+        it = owner.entries.emplace(key, entry(owner.memory)).first;
+    return it->second;
+}
+
+template<typename Key, typename T, std::size_t k, typename Hash, typename KeyHash, typename KeyEqual>
+void concurrent_sketch_map<Key, T, k, Hash, KeyHash, KeyEqual>::make_dense(stripe& owner, entry& sketch)
+{
+    if (sketch.dense != nullptr)
+        return;
+
+    const auto dense = static_cast<register_type*>(owner.memory.allocate(registers_count));
+    std::fill(dense, dense + registers_count, register_type{});
+    for (const auto value : sketch.sparse)
+    {
+        dense[value >> rank_bits] = static_cast<register_type>(value & ((1u << rank_bits) - 1));
+    }
+    sketch.dense = dense;
+    sparse_container(sketch.sparse.get_allocator()).swap(sketch.sparse);
+}
+
+template<typename Key, typename T, std::size_t k, typename Hash, typename KeyHash, typename KeyEqual>
+void concurrent_sketch_map<Key, T, k, Hash, KeyHash, KeyEqual>::update(stripe& owner, entry& sketch,
+                                                                     uint32_t index, uint32_t rank)
+{
+    if (sketch.dense == nullptr)
+    {
+        auto& sparse = sketch.sparse;
+        const auto position = static_cast<sparse_register>(index) << rank_bits;
+        const auto it = std::lower_bound(sparse.begin(), sparse.end(), position);
+        if (it != sparse.end() && (*it >> rank_bits) == index)
+        {
+            if ((*it & ((1u << rank_bits) - 1)) < rank)
+                *it = position | rank;
+            return;
+        }
+        if (sparse.size() < sparse_max)
+        {
+            sparse.insert(it, position | rank);
+            return;
+        }
+        make_dense(owner, sketch);
+    }
+
+    auto& target = sketch.dense[index];
+    if (static_cast<uint32_t>(target) < rank)
+        target = static_cast<register_type>(rank);
+}
+
+template<typename Key, typename T, std::size_t k, typename Hash, typename KeyHash, typename KeyEqual>
+auto concurrent_sketch_map<Key, T, k, Hash, KeyHash, KeyEqual>::estimate(const entry& sketch) -> size_type
+{
+    if (sketch.dense != nullptr)
+    {
+        const auto sums = hll::kernels::active().sum(sketch.dense, registers_count);
+        return hll::details::estimate_cardinality(sums, registers_count, hash_bits);
+    }
+
+    const auto zeros = registers_count - sketch.sparse.size();
+    hll::kernels::register_sum sums{static_cast<double>(zeros), zeros};
+    for (const auto value : sketch.sparse)
+    {
+        sums.sum += std::ldexp(1.0, -static_cast<int>(value & ((1u << rank_bits) - 1)));
+    }
+    return hll::details::estimate_cardinality(sums, registers_count, hash_bits);
+}
+
+template<typename Key, typename T, std::size_t k, typename Hash, typename KeyHash, typename KeyEqual>
+template<typename InputIt>
+void concurrent_sketch_map<Key, T, k, Hash, KeyHash, KeyEqual>::add(const Key& key, InputIt first, InputIt last)
+{
+    auto& owner = stripe_of(key);
+    hll::details::hash_blocks<Hash, T>(first, last, [&owner, &key](const hash_result_type* hashes, size_type count)
+    {
+        std::lock_guard<std::mutex> lock(owner.mutex);
+        auto& sketch = find_or_create(owner, key);
+        for (size_type i = 0; i < count; ++i)
+        {
+            update(owner, sketch, hll::details::register_index(hashes[i], k), hll::details::register_rank(hashes[i], k));
+        }
+    });
+}
+
+template<typename Key, typename T, std::size_t k, typename Hash, typename KeyHash, typename KeyEqual>
+void concurrent_sketch_map<Key, T, k, Hash, KeyHash, KeyEqual>::add_hash(const Key& key, hash_result_type hash_value)
+{
+    const auto index = hll::details::register_index(hash_value, k);
+    const auto rank = hll::details::register_rank(hash_value, k);
+    auto& owner = stripe_of(key);
+    std::lock_guard<std::mutex> lock(owner.mutex);
+    update(owner, find_or_create(owner, key), index, rank);
+}
+
+template<typename Key, typename T, std::size_t k, typename Hash, typename KeyHash, typename KeyEqual>
+auto concurrent_sketch_map<Key, T, k, Hash, KeyHash, KeyEqual>::count(const Key& key) const -> size_type
+{
+    const auto& owner = stripe_of(key);
+    std::lock_guard<std::mutex> lock(owner.mutex);
+    const auto it = owner.entries.find(key);
+    return it == owner.entries.end() ? 0 : estimate(it->second);
+}
+
+template<typename Key, typename T, std::size_t k, typename Hash, typename KeyHash, typename KeyEqual>
+auto concurrent_sketch_map<Key, T, k, Hash, KeyHash, KeyEqual>::sketch(const Key& key) const -> sketch_type
+{
+    sketch_type result{};
+    const auto& owner = stripe_of(key);
+    std::lock_guard<std::mutex> lock(owner.mutex);
+    const auto it = owner.entries.find(key);
+    if (it == owner.entries.end())
+        return result;
+
+    auto& registers = result.registers();
+    if (it->second.dense != nullptr)
+    {
+        std::copy(it->second.dense, it->second.dense + registers_count, registers.begin());
+        return result;
+    }
+    for (const auto value : it->second.sparse)
+    {
+        registers[value >> rank_bits] = static_cast<register_type>(value & ((1u << rank_bits) - 1));
+    }
+    return result;
+}
+
+template<typename Key, typename T, std::size_t k, typename Hash, typename KeyHash, typename KeyEqual>
+void concurrent_sketch_map<Key, T, k, Hash, KeyHash, KeyEqual>::merge(const Key& key, const sketch_type& rhs)
+{
+    auto& owner = stripe_of(key);
+    std::lock_guard<std::mutex> lock(owner.mutex);
+    auto& sketch = find_or_create(owner, key);
+    make_dense(owner, sketch);
+    hll::kernels::active().merge(sketch.dense, rhs.registers().data(), registers_count);
+}
+
+template<typename Key, typename T, std::size_t k, typename Hash, typename KeyHash, typename KeyEqual>
+bool concurrent_sketch_map<Key, T, k, Hash, KeyHash, KeyEqual>::erase(const Key& key)
+{
+    auto& owner = stripe_of(key);
+    std::lock_guard<std::mutex> lock(owner.mutex);
+    const auto it = owner.entries.find(key);
+    if (it == owner.entries.end())
+        return false;
+
+    if (it->second.dense != nullptr)
+        owner.memory.deallocate(it->second.dense, registers_count);
+    owner.entries.erase(it);
+    return true;
+}
+
+template<typename Key, typename T, std::size_t k, typename Hash, typename KeyHash, typename KeyEqual>
+auto concurrent_sketch_map<Key, T, k, Hash, KeyHash, KeyEqual>::size() const -> size_type
+{
+    size_type result = 0;
+    for (const auto& owner : m_stripes)
+    {
+        std::lock_guard<std::mutex> lock(owner->mutex);
+        result += owner->entries.size();
+    }
+    return result;
+}
+
+template<typename Key, typename T, std::size_t k, typename Hash, typename KeyHash, typename KeyEqual>
+void concurrent_sketch_map<Key, T, k, Hash, KeyHash, KeyEqual>::clear()
+{
+    for (const auto& owner : m_stripes)
+    {
+        std::lock_guard<std::mutex> lock(owner->mutex);
+        owner->entries.clear();
+        owner->memory.release();
+    }
+}
+
+template<typename Key, typename T, std::size_t k, typename Hash, typename KeyHash, typename KeyEqual>
+template<typename Fn>
+void concurrent_sketch_map<Key, T, k, Hash, KeyHash, KeyEqual>::for_each(Fn fn) const
+{
+    for (const auto& owner : m_stripes)
+    {
+        std::lock_guard<std::mutex> lock(owner->mutex);
+        for (const auto& item : owner->entries)
+        {
+            fn(item.first, estimate(item.second));
+        }
+    }
+}
+
+template<typename Key, typename T, std::size_t k, typename Hash, typename KeyHash, typename KeyEqual>
+auto concurrent_sketch_map<Key, T, k, Hash, KeyHash, KeyEqual>::snapshot() const
+-> std::vector<std::pair<Key, size_type>>
+{
+    std::vector<std::pair<Key, size_type>> result;
+    for_each([&result](const Key& key, size_type count)
+    {
+        result.emplace_back(key, count);
+    });
+    return result;
+}
+
+} // namespace hll
+
+#endif //HLL_CONCURRENT_SKETCH_MAP_HXX
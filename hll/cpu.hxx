@@ -0,0 +1,78 @@
+/**
+ * @file hll/cpu.hxx
+ * @brief Runtime detection of the instruction set extensions of the CPU
+ * @author Daniil Dudkin (unterumarmung)
+ */
+#ifndef HLL_CPU_HXX
+#define HLL_CPU_HXX
+
+#include "details.hxx" // HLL_X86_64
+
+#if HLL_X86_64 && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h> // _xgetbv
+#endif
+
+namespace hll
+{
+namespace cpu
+{
+
+/**
+ * Instruction set extensions usable by the process: supported by the CPU and enabled by the OS
+ */
+struct features
+{
+    bool sse42 = false;
+    bool popcnt = false;
+    bool avx2 = false;
+    bool avx512f = false;
+    bool avx512cd = false;
+    bool avx512bw = false;
+};
+
+/**
+ * Queries the CPU, prefer the cached get()
+ * @return the features
+ */
+inline features detect() noexcept
+{
+    features result;
+#if HLL_X86_64 && defined(__GNUC__)
+    __builtin_cpu_init();
+    result.sse42 = __builtin_cpu_supports("sse4.2") != 0;
+    result.popcnt = __builtin_cpu_supports("popcnt") != 0;
+    result.avx2 = __builtin_cpu_supports("avx2") != 0;
+    result.avx512f = __builtin_cpu_supports("avx512f") != 0;
+    result.avx512cd = __builtin_cpu_supports("avx512cd") != 0;
+    result.avx512bw = __builtin_cpu_supports("avx512bw") != 0;
+#elif HLL_X86_64 && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    result.sse42 = (info[2] & (1 << 20)) != 0;
+    result.popcnt = (info[2] & (1 << 23)) != 0;
+    const bool os_saves_ymm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+    const bool os_saves_zmm = os_saves_ymm && (_xgetbv(0) & 0xe0) == 0xe0;
+    __cpuidex(info, 7, 0);
+    result.avx2 = os_saves_ymm && (info[1] & (1 << 5)) != 0;
+    result.avx512f = os_saves_zmm && (info[1] & (1 << 16)) != 0;
+    result.avx512cd = os_saves_zmm && (info[1] & (1 << 28)) != 0;
+    result.avx512bw = os_saves_zmm && (info[1] & (1 << 30)) != 0;
+#endif
+    return result;
+}
+
+/**
+ * Get the features, detected once per process
+ * @return the features
+ */
+inline const features& get() noexcept
+{
+    static const features result = detect();
+    return result;
+}
+
+} // namespace cpu
+} // namespace hll
+
+#endif //HLL_CPU_HXX
@@ -0,0 +1,159 @@
+/**
+ * @file hll/crc32c.hxx
+ * @brief CRC-32C based hash policy, computed with the SSE4.2 crc32 instruction when the CPU has it
+ * @author Daniil Dudkin (unterumarmung)
+ */
+#ifndef HLL_CRC32C_HXX
+#define HLL_CRC32C_HXX
+
+#include <cstdint>
+#include <cstring> // std::memcpy
+#include <type_traits>
+
+#include "dispatch.hxx"
+#include "details.hxx"
+#include "hash.hxx"
+#include "traits.hxx"
+
+#if HLL_X86_64
+#include <nmmintrin.h>
+#endif
+
+namespace hll
+{
+namespace details
+{
+
+/// CRC-32C (Castagnoli) lookup table for the reflected polynomial 0x82f63b78
+struct crc32c_table
+{
+    uint32_t entries[256];
+
+    crc32c_table() noexcept : entries()
+    {
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            auto crc = i;
+            for (int bit = 0; bit < 8; ++bit)
+            {
+                crc = (crc >> 1u) ^ (0x82f63b78u & (0u - (crc & 1u)));
+            }
+            entries[i] = crc;
+        }
+    }
+};
+
+inline uint32_t crc32c_software(const uint8_t* data, std::size_t length, uint32_t crc) noexcept
+{
+    static const crc32c_table table;
+    crc = ~crc;
+    for (std::size_t i = 0; i < length; ++i)
+    {
+        crc = table.entries[(crc ^ data[i]) & 0xffu] ^ (crc >> 8u);
+    }
+    return ~crc;
+}
+
+#if HLL_X86_64
+
+HLL_TARGET("sse4.2")
+inline uint32_t crc32c_hardware(const uint8_t* data, std::size_t length, uint32_t crc) noexcept
+{
+    uint64_t state = ~crc;
+    for (; length >= 8; length -= 8, data += 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        state = _mm_crc32_u64(state, word);
+    }
+    auto state32 = static_cast<uint32_t>(state);
+    if (length >= 4)
+    {
+        uint32_t word;
+        std::memcpy(&word, data, sizeof(word));
+        state32 = _mm_crc32_u32(state32, word);
+        length -= 4;
+        data += 4;
+    }
+    for (; length > 0; --length, ++data)
+    {
+        state32 = _mm_crc32_u8(state32, *data);
+    }
+    return ~state32;
+}
+
+#endif // HLL_X86_64
+
+/**
+ * murmurhash3's finalizer, CRC is well distributed but linear, so equal bit patterns of the input stay visible
+ * @param h the value
+ * @return the mixed value
+ */
+HLL_CONSTEXPR_OR_INLINE uint32_t fmix32(uint32_t h) noexcept
+{
+    h ^= h >> 16u;
+    h *= 0x85ebca6b;
+    h ^= h >> 13u;
+    h *= 0xc2b2ae35;
+    h ^= h >> 16u;
+    return h;
+}
+
+} // namespace details
+
+/**
+ * CRC-32C of the bytes.
+ * The crc32 instruction is used at the SSE4.2 dispatch level and above, otherwise a lookup table,
+ * both give the same values, so sketches built on different machines can be merged
+ * @param key data pointer
+ * @param length data length
+ * @param seed
+ * @return the checksum
+ */
+inline uint32_t crc32c(const void* key, std::size_t length, uint32_t seed) noexcept
+{
+    const auto data = static_cast<const uint8_t*>(key);
+#if HLL_X86_64 && defined(__SSE4_2__)
+    // built for SSE4.2 anyway: no dispatch, and the loops of the constant-size keys are unrolled when inlined
+    return details::crc32c_hardware(data, length, seed);
+#elif HLL_X86_64
+    return dispatch::active() >= dispatch::level::sse42 ? details::crc32c_hardware(data, length, seed)
+                                                        : details::crc32c_software(data, length, seed);
+#else
+    return details::crc32c_software(data, length, seed);
+#endif
+}
+
+/**
+ * Hash policy for hyper_log_log: CRC-32C finalized by the murmurhash3 mixer.
+ * Hashes short keys, like integers, several times faster than murmurhash3 on CPUs with SSE4.2
+ * @tparam Seed the seed
+ */
+template<hash_result Seed>
+struct basic_crc32c_hash
+{
+    /// type of the produced hashes
+    using result_type = hash_result;
+    /// contiguous containers hash by their bytes
+    using is_transparent = void;
+    static constexpr hash_result seed = Seed;
+
+    template<typename T, typename std::enable_if<std::is_fundamental<T>::value>::type* = nullptr>
+    result_type operator()(const T& value) const noexcept
+    {
+        return details::fmix32(crc32c(&value, sizeof(T), Seed));
+    }
+
+    template<typename T, typename std::enable_if<hll::traits::is_ra_fundamental_container<T>::value>::type* = nullptr>
+    result_type operator()(const T& value) const noexcept(noexcept(value.data()) && noexcept(value.size()))
+    {
+        return details::fmix32(crc32c(value.data(), value.size() * sizeof(typename T::value_type), Seed));
+    }
+};
+
+/// CRC-32C hash policy with seed 0
+using crc32c_hash = basic_crc32c_hash<0>;
+
+} // namespace hll
+
+#endif //HLL_CRC32C_HXX
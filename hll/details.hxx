@@ -18,6 +18,44 @@ namespace details
 
 #endif // __cplusplus >= 201402L
 
+#if defined(__x86_64__) || defined(_M_X64)
+
+#define HLL_X86_64 1
+
+#endif // defined(__x86_64__) || defined(_M_X64)
+
+#if defined(__GNUC__)
+
+/// compiles a function for the given instruction set extensions, to be called after checking the CPU supports them
+#define HLL_TARGET(isa) __attribute__((target(isa)))
+
+#else
+
+#define HLL_TARGET(isa)
+
+#endif // defined(__GNUC__)
+
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define HLL_HAS_IS_CONSTANT_EVALUATED 1
+#endif
+#elif defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 9
+#define HLL_HAS_IS_CONSTANT_EVALUATED 1
+#elif defined(_MSC_VER) && _MSC_VER >= 1925
+#define HLL_HAS_IS_CONSTANT_EVALUATED 1
+#endif
+
+#if defined(HLL_HAS_IS_CONSTANT_EVALUATED) && __cplusplus >= 201402L
+
+/// true while a constant expression is evaluated, the dispatched kernels are not constexpr
+#define HLL_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+
+#else
+
+#define HLL_IS_CONSTANT_EVALUATED() false
+
+#endif // defined(HLL_HAS_IS_CONSTANT_EVALUATED) && __cplusplus >= 201402L
+
 } // namespace details
 } // namespace hll
 
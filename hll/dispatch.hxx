@@ -0,0 +1,107 @@
+/**
+ * @file hll/dispatch.hxx
+ * @brief Selection of the instruction set level of the kernels, once per process
+ * @author Daniil Dudkin (unterumarmung)
+ */
+#ifndef HLL_DISPATCH_HXX
+#define HLL_DISPATCH_HXX
+
+#include <atomic>
+
+#include "cpu.hxx"
+#include "details.hxx" // HLL_X86_64
+
+namespace hll
+{
+namespace dispatch
+{
+
+/**
+ * Instruction set levels of the kernels, every level includes the ones below it
+ */
+enum class level : int
+{
+    scalar = 0,
+    sse42 = 1, ///< SSE4.2 and POPCNT
+    avx2 = 2,
+    avx512 = 3 ///< AVX-512 F, BW and CD
+};
+
+/**
+ * Get the highest level the CPU supports
+ * @return the level
+ */
+inline level detect() noexcept
+{
+#if HLL_X86_64
+    const auto& features = cpu::get();
+    // POPCNT has its own CPUID bit, the kernels of every level count the zero registers with it
+    if (!features.sse42 || !features.popcnt)
+        return level::scalar;
+    if (features.avx512f && features.avx512bw && features.avx512cd)
+        return level::avx512;
+    if (features.avx2)
+        return level::avx2;
+    return level::sse42;
+#endif
+    return level::scalar;
+}
+
+namespace details
+{
+
+inline std::atomic<int>& selected() noexcept
+{
+    static std::atomic<int> value{static_cast<int>(detect())};
+    return value;
+}
+
+} // namespace details
+
+/**
+ * Get the level the kernels run at
+ * @return the level
+ */
+inline level active() noexcept
+{
+    return static_cast<level>(details::selected().load(std::memory_order_relaxed));
+}
+
+/**
+ * Make the kernels run at a lower level than detected, e.g. to compare the levels in a benchmark.
+ * Levels the CPU does not support are lowered to the detected one
+ * @param requested the level
+ * @return the level the kernels run at
+ */
+inline level force(level requested) noexcept
+{
+    const auto supported = detect();
+    const auto result = static_cast<int>(requested) < static_cast<int>(supported) ? requested : supported;
+    details::selected().store(static_cast<int>(result), std::memory_order_relaxed);
+    return result;
+}
+
+/**
+ * Get the name of the level
+ * @param value the level
+ * @return "scalar", "sse4.2", "avx2" or "avx512"
+ */
+inline const char* name(level value) noexcept
+{
+    switch (value)
+    {
+        case level::sse42:
+            return "sse4.2";
+        case level::avx2:
+            return "avx2";
+        case level::avx512:
+            return "avx512";
+        default:
+            return "scalar";
+    }
+}
+
+} // namespace dispatch
+} // namespace hll
+
+#endif //HLL_DISPATCH_HXX
@@ -0,0 +1,284 @@
+/**
+ * @file hll/dynamic_hyper_log_log.hxx
+ * @brief HyperLogLog with the precision chosen at runtime
+ * @author Daniil Dudkin (unterumarmung)
+ */
+#ifndef HLL_DYNAMIC_HYPER_LOG_LOG_HXX
+#define HLL_DYNAMIC_HYPER_LOG_LOG_HXX
+
+#include <algorithm> // std::max, std::copy, std::fill
+#include <cmath> // std::sqrt
+#include <stdexcept> // std::invalid_argument
+#include <memory> // std::allocator
+#include <type_traits>
+#include <vector>
+#include "hyper_log_log.hxx"
+
+namespace hll
+{
+
+/**
+ * @brief HyperLogLog with the precision chosen at runtime, e.g. read from a config or from serialized data.
+ * Registers, hashing, merge, folding and count are the same as hyper_log_log's with the same k and Hash,
+ * so the sketches produce equal estimates and convert into each other
+ * @tparam T the type of values
+ * @tparam Hash hash policy, as in hyper_log_log
+ * @tparam Allocator allocator of the registers, e.g. hll::slab_allocator for many short-lived sketches,
+ * which makes the allocation cheap, the registers are zeroed on creation and by clear() with any allocator
+ */
+template<typename T, typename Hash = hll::murmur3_hash, typename Allocator = std::allocator<int8_t>>
+class dynamic_hyper_log_log
+{
+public:
+    /// type of registers of the data structure
+    using register_type = int8_t;
+    /// type of size values
+    using size_type = size_t;
+    using value_type = T;
+    using hasher = Hash;
+    using hash_result_type = typename Hash::result_type;
+    using this_type = dynamic_hyper_log_log;
+    /// number of bits of the hash values
+    static constexpr size_type hash_bits = sizeof(hash_result_type) * 8;
+    /// type of the registers' storage
+    using container_type = std::vector<register_type, Allocator>;
+    using allocator_type = Allocator;
+    static constexpr size_type min_precision = 4;
+    static constexpr size_type max_precision = 30;
+
+private:
+    static_assert(std::is_same<hash_result_type, uint32_t>::value || std::is_same<hash_result_type, uint64_t>::value,
+                  "Hash::result_type must be uint32_t or uint64_t");
+    static_assert(hll::traits::is_hash_policy_for<Hash, T>::value,
+                  "Hash must be callable with const T& and return Hash::result_type");
+
+    static size_type checked_precision(size_type k)
+    {
+        if (k < min_precision || k > max_precision)
+            throw std::invalid_argument("hll::dynamic_hyper_log_log: k must be in a range [4; 30]");
+        return k;
+    }
+
+    size_type m_k;
+    container_type m_registers;
+public:
+    /**
+     * Construct an empty sketch
+     * @param k number that controls number of registers as 2^k, throws std::invalid_argument if not in [4; 30]
+     * @param allocator allocator of the registers
+     */
+    explicit dynamic_hyper_log_log(size_type k, const allocator_type& allocator = allocator_type())
+            : m_k(checked_precision(k)), m_registers(static_cast<size_type>(1) << k, register_type{}, allocator)
+    {
+    }
+
+    /**
+     * Construct a sketch with the registers of a sketch of a compile-time precision
+     * @param source the sketch
+     * @param allocator allocator of the registers
+     */
+    template<std::size_t k>
+    explicit dynamic_hyper_log_log(const hyper_log_log<T, k, Hash>& source,
+                                   const allocator_type& allocator = allocator_type())
+            : m_k(k), m_registers(source.registers().begin(), source.registers().end(), allocator)
+    {
+    }
+
+    /**
+     * Get the precision
+     * @return k, the sketch has 2^k registers
+     */
+    size_type precision() const noexcept
+    {
+        return m_k;
+    }
+
+    /**
+     * Get the allocator of the registers
+     * @return the allocator
+     */
+    allocator_type get_allocator() const
+    {
+        return m_registers.get_allocator();
+    }
+
+    /**
+     * Get number of the registers
+     * @return 2^k
+     */
+    size_type registers_count() const noexcept
+    {
+        return m_registers.size();
+    }
+
+    /**
+     * Get unique numbers count
+     * @return - the count
+     */
+    size_type count() const;
+
+    /**
+     * Add an element
+     * @param value - the element
+     */
+    void add(const value_type& value)
+    {
+        add_hash(Hash{}(value));
+    }
+
+    /**
+     * Add an element given as another type hashing the same as value_type does, without converting it
+     * @param value the element
+     */
+    template<typename U, typename std::enable_if<
+            hll::traits::is_heterogeneous_key_for<Hash, T, U>::value>::type* = nullptr>
+    void add(const U& value)
+    {
+        add_hash(Hash{}(hll::details::as_key(value)));
+    }
+
+    /**
+     * Add elements, hashing them in blocks before updating the registers
+     * @param first the first element
+     * @param last past the last element
+     */
+    template<typename InputIt>
+    void add(InputIt first, InputIt last);
+
+    /**
+     * Add an element by its hash, e.g. a fingerprint computed upstream
+     * @param hash_value the hash of the element
+     */
+    void add_hash(hash_result_type hash_value) noexcept;
+
+    /**
+     * Add elements by their hashes
+     * @param hashes the hashes of the elements
+     * @param count number of the hashes
+     */
+    void add_hashes(const hash_result_type* hashes, size_type count) noexcept;
+
+    /**
+     * Get the registers of the data structure
+     * @return registers
+     */
+    const container_type& registers() const noexcept
+    {
+        return m_registers;
+    }
+
+    /**
+     * Get the registers of the data structure, e.g. to load them from a serialized form.
+     * They must not be resized
+     * @return registers
+     */
+    container_type& registers() noexcept
+    {
+        return m_registers;
+    }
+
+    /**
+     * Get the hash policy
+     * @return the hash function object
+     */
+    hasher hash_function() const noexcept
+    {
+        return hasher{};
+    }
+
+    /**
+     * Get relative error of the data structure
+     * @return - the error
+     */
+    double get_relative_error() const
+    {
+        return 1.04 / std::sqrt(static_cast<double>(registers_count()));
+    }
+
+    /**
+     * Clear the data structure
+     */
+    void clear() noexcept
+    {
+        std::fill(m_registers.begin(), m_registers.end(), register_type{});
+    }
+
+    /**
+     * HyperLogLog's merge operation. A sketch of a higher precision is folded into this precision on the fly
+     * @param rhs A HyperLogLog instance of the same or a higher precision to merge with
+     * @return false if rhs has a lower precision, the sketch is left unchanged then
+     */
+    bool merge(const this_type& rhs) noexcept;
+
+    /**
+     * Fold the sketch into a lower precision, the result equals the sketch of the same values made at k2
+     * @param k2 the precision, throws std::invalid_argument if not in [4; precision()]
+     * @return the folded sketch
+     */
+    this_type fold(size_type k2) const;
+};
+
+template<typename T, typename Hash, typename Allocator>
+auto dynamic_hyper_log_log<T, Hash, Allocator>::count() const -> size_type
+{
+    const auto sums = hll::kernels::active().sum(m_registers.data(), m_registers.size());
+    return hll::details::estimate_cardinality(sums, m_registers.size(), hash_bits);
+}
+
+template<typename T, typename Hash, typename Allocator>
+template<typename InputIt>
+void dynamic_hyper_log_log<T, Hash, Allocator>::add(InputIt first, InputIt last)
+{
+    hll::details::hash_blocks<Hash, T>(first, last, [this](const hash_result_type* hashes, size_type count)
+    {
+        add_hashes(hashes, count);
+    });
+}
+
+template<typename T, typename Hash, typename Allocator>
+void dynamic_hyper_log_log<T, Hash, Allocator>::add_hashes(const hash_result_type* hashes, size_type count) noexcept
+{
+    if (hll::kernels::add_hashes(m_registers.data(), hashes, count, static_cast<unsigned>(m_k)))
+        return;
+
+    for (size_type i = 0; i < count; ++i)
+    {
+        add_hash(hashes[i]);
+    }
+}
+
+template<typename T, typename Hash, typename Allocator>
+void dynamic_hyper_log_log<T, Hash, Allocator>::add_hash(hash_result_type hash_value) noexcept
+{
+    const auto index = hll::details::register_index(hash_value, m_k);
+    const auto rank = hll::details::register_rank(hash_value, m_k);
+    m_registers[index] = static_cast<register_type>(std::max(static_cast<uint32_t>(m_registers[index]), rank));
+}
+
+template<typename T, typename Hash, typename Allocator>
+bool dynamic_hyper_log_log<T, Hash, Allocator>::merge(const this_type& rhs) noexcept
+{
+    if (rhs.m_k < m_k)
+        return false;
+
+    if (rhs.m_k == m_k)
+        hll::kernels::active().merge(m_registers.data(), rhs.m_registers.data(), m_registers.size());
+    else
+        hll::details::fold_registers<hash_result_type>(rhs.m_registers.data(), rhs.m_k, m_registers.data(), m_k);
+    return true;
+}
+
+template<typename T, typename Hash, typename Allocator>
+auto dynamic_hyper_log_log<T, Hash, Allocator>::fold(size_type k2) const -> this_type
+{
+    if (k2 > m_k)
+        throw std::invalid_argument("hll::dynamic_hyper_log_log: a sketch can be folded into a lower precision only");
+
+    this_type result(k2, m_registers.get_allocator());
+    hll::details::fold_registers<hash_result_type>(m_registers.data(), m_k, result.m_registers.data(), k2);
+    return result;
+}
+
+} // namespace hll
+
+#endif //HLL_DYNAMIC_HYPER_LOG_LOG_HXX
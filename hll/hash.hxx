@@ -1,46 +1,413 @@
 /**
  * @file hll/hash.hxx
- * @brief This file contains hash-function wrappers of murmurhash3
+ * @brief This file contains hash-function wrappers of murmurhash3 and murmurhash64a
  * @author Daniil Dudkin (unterumarmung)
  */
 #ifndef HLL_HASH_HXX
 #define HLL_HASH_HXX
 
+#include <cstring> // std::memcpy
 #include <type_traits>
 
+#include "hash_append.hxx"
 #include "murmur_hash.hxx"
+#include "murmur_hash_batch.hxx"
 #include "traits.hxx"
 
 namespace hll
 {
 /// type alias for hash functions return-type
 using hash_result = uint32_t;
+/// type alias for 64-bit hash functions return-type
+using hash64_result = uint64_t;
+
+namespace details
+{
+
+/// the unsigned type of the bits of an integral type, std::make_unsigned does not take bool
+template<typename T>
+struct unsigned_bits : std::make_unsigned<T>
+{
+};
+
+template<>
+struct unsigned_bits<bool>
+{
+    using type = uint8_t;
+};
+
+/// bytes of an integral value
+template<typename T>
+struct integral_bytes
+{
+    uint8_t bytes[sizeof(T)];
+};
 
 /**
- * Hashes the fundamental types
+ * Get the little-endian bytes of an integral value by shifts, so they are the same on every platform
+ * and can be hashed in constant expressions
+ * @param value the value
+ * @return the bytes
+ */
+template<typename T>
+HLL_CONSTEXPR_OR_INLINE integral_bytes<T> to_bytes(T value) noexcept
+{
+    integral_bytes<T> result{};
+    const auto bits = static_cast<typename unsigned_bits<T>::type>(value);
+    for (std::size_t i = 0; i < sizeof(T); ++i)
+    {
+        result.bytes[i] = static_cast<uint8_t>(bits >> (8u * i));
+    }
+    return result;
+}
+
+} // namespace details
+
+/**
+ * Hashes the integral types by their little-endian bytes, usable in constant expressions since C++14
  * @tparam T the value type
  * @param value the value
+ * @param seed the seed
  * @return hash
  */
-template<typename T, typename std::enable_if<std::is_fundamental<T>::value>::type* = nullptr>
-constexpr hash_result hash(const T& value) noexcept
+template<typename T, typename std::enable_if<std::is_integral<T>::value>::type* = nullptr>
+HLL_CONSTEXPR_OR_INLINE hash_result hash(const T& value, hash_result seed = 0) noexcept
 {
-    return murmur_hash(&value, sizeof(T), /*seed = */ 0);
+    return murmur_hash_bytes(details::to_bytes(value).bytes, sizeof(T), seed);
 }
 
 /**
- * Hashes "random-access" containers of the fundamental types
+ * Hashes the other fundamental types: floating-point and std::nullptr_t
+ * @tparam T the value type
+ * @param value the value
+ * @param seed the seed
+ * @return hash
+ */
+template<typename T, typename std::enable_if<std::is_fundamental<T>::value
+                                             && !std::is_integral<T>::value>::type* = nullptr>
+inline hash_result hash(const T& value, hash_result seed = 0) noexcept
+{
+    return murmur_hash(&value, sizeof(T), seed);
+}
+
+/**
+ * Hashes containers of characters, usable in constant expressions since C++14, e.g. for std::string_view
+ * @tparam T the container type, must have T::size and T::data member functions and T::value_type member type
+ * @param value the container
+ * @param seed the seed
+ * @return hash
+ */
+template<typename T, typename std::enable_if<hll::traits::is_byte_container<T>::value>::type* = nullptr>
+HLL_CONSTEXPR_OR_INLINE hash_result hash(const T& value, hash_result seed = 0)
+noexcept(noexcept(value.data()) && noexcept(value.size()))
+{
+    return murmur_hash_bytes(value.data(), static_cast<uint32_t>(value.size()), seed);
+}
+
+/**
+ * Hashes "random-access" containers of the other fundamental types
  * @tparam T the container type, must have T::size and T::data member functions and T::value_type member type
  * @param value the container
+ * @param seed the seed
  * @return hash
  */
-template<typename T, typename std::enable_if<hll::traits::is_ra_fundamental_container<T>::value>::type* = nullptr>
-constexpr hash_result hash(const T& value)
+template<typename T, typename std::enable_if<hll::traits::is_ra_fundamental_container<T>::value
+                                             && !hll::traits::is_byte_container<T>::value>::type* = nullptr>
+inline hash_result hash(const T& value, hash_result seed = 0)
 noexcept(noexcept(value.data()) && noexcept(value.size()))
 {
-    return murmur_hash(value.data(), value.size() * sizeof(T::value_type), /*seed = */ 0);
+    return murmur_hash(value.data(), static_cast<uint32_t>(value.size() * sizeof(typename T::value_type)), seed);
 }
 
+/**
+ * Hashes non-contiguous containers of the fundamental types, like std::deque<char>,
+ * the same as a contiguous container of the same elements hashes
+ * @tparam T the container type
+ * @param value the container
+ * @param seed the seed
+ * @return hash
+ */
+template<typename T, typename std::enable_if<hll::traits::is_noncontiguous_fundamental_range<T>::value>::type* = nullptr>
+hash_result hash(const T& value, hash_result seed = 0) noexcept
+{
+    murmur3_hasher hasher(seed);
+    for (const auto& element : value)
+    {
+        hasher.update(&element, sizeof(element));
+    }
+    return hasher.finalize();
+}
+
+/**
+ * Hashes a byte string scattered across buffers, the same as the buffers copied together hash
+ * @param value the segments
+ * @param seed the seed
+ * @return hash
+ */
+inline hash_result hash(const byte_segments& value, hash_result seed = 0) noexcept
+{
+    murmur3_hasher hasher(seed);
+    for (std::size_t i = 0; i < value.count; ++i)
+    {
+        hasher.update(value.segments[i].data, value.segments[i].size);
+    }
+    return hasher.finalize();
+}
+
+/**
+ * Hashes composite values, like pairs, tuples or structs with a hash_append overload, without copying them
+ * @tparam T the value type
+ * @param value the value
+ * @param seed the seed
+ * @return hash
+ */
+template<typename T, typename std::enable_if<hll::traits::is_hash_appendable<T>::value
+                                             && !std::is_fundamental<T>::value
+                                             && !hll::traits::is_ra_fundamental_container<T>::value
+                                             && !hll::traits::is_noncontiguous_fundamental_range<T>::value
+                                             && !std::is_same<T, byte_segments>::value>::type* = nullptr>
+hash_result hash(const T& value, hash_result seed = 0) noexcept
+{
+    murmur3_hasher hasher(seed);
+    hash_append(hasher, value);
+    return hasher.finalize();
+}
+
+/**
+ * Hashes the integral types into 64 bits by their little-endian bytes, usable in constant expressions since C++14
+ * @tparam T the value type
+ * @param value the value
+ * @param seed the seed
+ * @return hash
+ */
+template<typename T, typename std::enable_if<std::is_integral<T>::value>::type* = nullptr>
+HLL_CONSTEXPR_OR_INLINE hash64_result hash64(const T& value, uint64_t seed) noexcept
+{
+    return murmur_hash64a_bytes(details::to_bytes(value).bytes, sizeof(T), seed);
+}
+
+/**
+ * Hashes the other fundamental types into 64 bits
+ * @tparam T the value type
+ * @param value the value
+ * @param seed the seed
+ * @return hash
+ */
+template<typename T, typename std::enable_if<std::is_fundamental<T>::value
+                                             && !std::is_integral<T>::value>::type* = nullptr>
+inline hash64_result hash64(const T& value, uint64_t seed) noexcept
+{
+    return murmur_hash64a(&value, sizeof(T), seed);
+}
+
+/**
+ * Hashes containers of characters into 64 bits, usable in constant expressions since C++14
+ * @tparam T the container type, must have T::size and T::data member functions and T::value_type member type
+ * @param value the container
+ * @param seed the seed
+ * @return hash
+ */
+template<typename T, typename std::enable_if<hll::traits::is_byte_container<T>::value>::type* = nullptr>
+HLL_CONSTEXPR_OR_INLINE hash64_result hash64(const T& value, uint64_t seed)
+noexcept(noexcept(value.data()) && noexcept(value.size()))
+{
+    return murmur_hash64a_bytes(value.data(), value.size(), seed);
+}
+
+/**
+ * Hashes "random-access" containers of the other fundamental types into 64 bits
+ * @tparam T the container type, must have T::size and T::data member functions and T::value_type member type
+ * @param value the container
+ * @param seed the seed
+ * @return hash
+ */
+template<typename T, typename std::enable_if<hll::traits::is_ra_fundamental_container<T>::value
+                                             && !hll::traits::is_byte_container<T>::value>::type* = nullptr>
+inline hash64_result hash64(const T& value, uint64_t seed)
+noexcept(noexcept(value.data()) && noexcept(value.size()))
+{
+    return murmur_hash64a(value.data(), value.size() * sizeof(typename T::value_type), seed);
+}
+
+namespace details
+{
+
+/**
+ * Characters of a C string or a character array, a contiguous container hashing as std::basic_string does
+ */
+template<typename Char>
+struct char_view
+{
+    using value_type = Char;
+
+    constexpr const Char* data() const noexcept
+    {
+        return m_data;
+    }
+
+    constexpr std::size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    const Char* m_data;
+    std::size_t m_size;
+};
+
+/// a C string up to the terminating null, taken by reference not to be ambiguous with arrays
+template<typename Pointer, typename std::enable_if<std::is_pointer<Pointer>::value>::type* = nullptr,
+        typename Char = typename std::remove_cv<typename std::remove_pointer<Pointer>::type>::type>
+HLL_CONSTEXPR_OR_INLINE char_view<Char> as_key(const Pointer& c_string) noexcept
+{
+    std::size_t size = 0;
+    while (c_string[size] != Char{})
+    {
+        ++size;
+    }
+    return {c_string, size};
+}
+
+/// a character array up to the first null, e.g. a string literal without its terminator
+template<typename Char, std::size_t N>
+HLL_CONSTEXPR_OR_INLINE char_view<Char> as_key(const Char (& array)[N]) noexcept
+{
+    std::size_t size = 0;
+    while (size < N && array[size] != Char{})
+    {
+        ++size;
+    }
+    return {array, size};
+}
+
+template<typename T, typename std::enable_if<!std::is_pointer<T>::value && !std::is_array<T>::value>::type* = nullptr>
+constexpr const T& as_key(const T& value) noexcept
+{
+    return value;
+}
+
+} // namespace details
+
+/**
+ * Hash policies of hyper_log_log are stateless function objects: a result_type member type
+ * of uint32_t or uint64_t and a const call operator taking the value.
+ * Everything affecting the hash values, like seeds, is a part of the policy type,
+ * so sketches of the same type always hash alike and can be merged.
+ * A policy may also hash byte strings by the batch with a hash_batch member function,
+ * hyper_log_log uses it to add ranges of contiguous containers.
+ * A policy hashing contiguous containers by their bytes declares is_transparent member type,
+ * then hyper_log_log<std::string, k> takes string views, character arrays and C strings as they are.
+ */
+
+/**
+ * Hash policy for hyper_log_log: 32-bit murmurhash3
+ * @tparam Seed the seed
+ */
+template<hash_result Seed>
+struct basic_murmur3_hash
+{
+    /// type of the produced hashes
+    using result_type = hash_result;
+    /// contiguous containers hash by their bytes
+    using is_transparent = void;
+    static constexpr hash_result seed = Seed;
+
+    template<typename T>
+    constexpr auto operator()(const T& value) const noexcept(noexcept(hll::hash(value, Seed)))
+    -> decltype(hll::hash(value, Seed))
+    {
+        return hll::hash(value, Seed);
+    }
+
+    /**
+     * Hashes byte strings by the batch, several at once where the CPU allows,
+     * the same values as the call operator gives for contiguous containers
+     * @param keys data pointers
+     * @param lengths data lengths in bytes
+     * @param count number of the keys
+     * @param hashes the results
+     */
+    void hash_batch(const void* const* keys, const std::size_t* lengths, std::size_t count, result_type* hashes)
+    const noexcept
+    {
+        murmur_hash_batch(keys, lengths, count, Seed, hashes);
+    }
+};
+
+/// the default hash policy: murmurhash3 with seed 0
+using murmur3_hash = basic_murmur3_hash<0>;
+
+/**
+ * Hash policy for hyper_log_log: 64-bit murmurhash64a
+ * @tparam Seed the seed
+ */
+template<hash64_result Seed>
+struct basic_murmur64a_hash
+{
+    /// type of the produced hashes
+    using result_type = hash64_result;
+    /// contiguous containers hash by their bytes
+    using is_transparent = void;
+    static constexpr hash64_result seed = Seed;
+
+    template<typename T>
+    constexpr auto operator()(const T& value) const noexcept(noexcept(hll::hash64(value, Seed)))
+    -> decltype(hll::hash64(value, Seed))
+    {
+        return hll::hash64(value, Seed);
+    }
+};
+
+/// murmurhash64a with the seed used by Redis, so byte strings hash exactly as they do for PFADD
+using murmur64a_hash = basic_murmur64a_hash<0xadc83b19>;
+
+/**
+ * Hash policy for values that are uniformly random already, like UUIDv4 or random 64/128-bit identifiers.
+ * Integers of the hash width are used as is, larger trivially copyable values are folded with xor
+ * word by word, so a few fixed bits (like the version bits of a UUID) do not skew the result.
+ * Integers of another width are rejected: identity_hash<uint32_t> takes 32-bit integers only,
+ * 64-bit precomputed hashes need identity_hash<uint64_t>
+ * @tparam Result uint32_t or uint64_t
+ */
+template<typename Result = hash64_result>
+struct identity_hash
+{
+    /// type of the produced hashes
+    using result_type = Result;
+
+    template<typename T, typename std::enable_if<std::is_integral<T>::value
+                                                 && sizeof(T) == sizeof(Result)>::type* = nullptr>
+    constexpr result_type operator()(const T& value) const noexcept
+    {
+        return static_cast<result_type>(value);
+    }
+
+    template<typename T, typename std::enable_if<!std::is_integral<T>::value
+                                                 && std::is_trivially_copyable<T>::value
+                                                 && sizeof(T) % sizeof(Result) == 0>::type* = nullptr>
+    result_type operator()(const T& value) const noexcept
+    {
+        const auto bytes = reinterpret_cast<const unsigned char*>(&value);
+        result_type result = 0;
+        for (std::size_t offset = 0; offset < sizeof(T); offset += sizeof(Result))
+        {
+            result_type word;
+            std::memcpy(&word, bytes + offset, sizeof(word));
+            result ^= word;
+        }
+        return result;
+    }
+
+    template<typename T, typename std::enable_if<std::is_integral<T>::value
+                                                 && sizeof(T) != sizeof(Result)>::type* = nullptr>
+    result_type operator()(const T&) const noexcept
+    {
+        static_assert(sizeof(T) == sizeof(Result),
+                      "identity_hash takes integers of its result's width only, "
+                      "use identity_hash<uint64_t> for 64-bit values and identity_hash<uint32_t> for 32-bit ones");
+        return 0;
+    }
+};
+
 } //namespace hll
 
 
@@ -0,0 +1,287 @@
+/**
+ * @file hll/hash_append.hxx
+ * @brief Incremental murmurhash3 and the hash_append customization point for composite and non-contiguous keys
+ * @author Daniil Dudkin (unterumarmung)
+ */
+#ifndef HLL_HASH_APPEND_HXX
+#define HLL_HASH_APPEND_HXX
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring> // std::memcpy
+#include <iterator> // std::begin, std::end
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "traits.hxx"
+
+namespace hll
+{
+
+/**
+ * MurmurHash3 computed incrementally: the bytes may come in any number of pieces,
+ * the result is the same as murmur_hash of all of them at once
+ */
+class murmur3_hasher
+{
+public:
+    /**
+     * @param seed the seed
+     */
+    explicit constexpr murmur3_hasher(uint32_t seed = 0) noexcept
+            : m_hash(seed), m_tail(0), m_tail_size(0), m_length(0)
+    {
+    }
+
+    /**
+     * Hash the next bytes
+     * @param data data pointer
+     * @param length data length
+     */
+    void update(const void* data, std::size_t length) noexcept
+    {
+        auto bytes = static_cast<const uint8_t*>(data);
+        m_length += static_cast<uint32_t>(length);
+        // complete the chunk the previous bytes have started
+        for (; m_tail_size != 0 && length > 0; --length, ++bytes)
+        {
+            m_tail |= static_cast<uint32_t>(*bytes) << (8u * m_tail_size);
+            if (++m_tail_size == 4)
+            {
+                mix_chunk(m_tail);
+                m_tail = 0;
+                m_tail_size = 0;
+            }
+        }
+        for (; length >= 4; length -= 4, bytes += 4)
+        {
+            uint32_t chunk;
+            std::memcpy(&chunk, bytes, sizeof(chunk));
+            mix_chunk(chunk);
+        }
+        for (; length > 0; --length, ++bytes)
+        {
+            m_tail |= static_cast<uint32_t>(*bytes) << (8u * m_tail_size++);
+        }
+    }
+
+    /**
+     * Get the hash of the bytes so far, the hasher may be updated further
+     * @return hash
+     */
+    uint32_t finalize() const noexcept
+    {
+        auto h = m_hash;
+        h ^= rotl(m_tail * c1, 15) * c2;
+        h ^= m_length;
+        h ^= h >> 16u;
+        h *= 0x85ebca6b;
+        h ^= h >> 13u;
+        h *= 0xc2b2ae35;
+        h ^= h >> 16u;
+        return h;
+    }
+
+private:
+    static constexpr uint32_t c1 = 0xcc9e2d51;
+    static constexpr uint32_t c2 = 0x1b873593;
+
+    static constexpr uint32_t rotl(uint32_t value, uint32_t shift) noexcept
+    {
+        return (value << shift) | (value >> (32 - shift));
+    }
+
+    void mix_chunk(uint32_t chunk) noexcept
+    {
+        m_hash ^= rotl(chunk * c1, 15) * c2;
+        m_hash = rotl(m_hash, 13) * 5 + 0xe6546b64;
+    }
+
+    uint32_t m_hash;
+    /// the bytes of an incomplete chunk, a zero tail mixes into zero as murmur_hash has it
+    uint32_t m_tail;
+    uint32_t m_tail_size;
+    uint32_t m_length;
+};
+
+/**
+ * A piece of a byte string scattered across buffers, like iovec
+ */
+struct byte_segment
+{
+    const void* data;
+    std::size_t size;
+};
+
+/**
+ * A byte string scattered across buffers, hashes as the bytes of all the segments one after another
+ */
+struct byte_segments
+{
+    const byte_segment* segments;
+    std::size_t count;
+};
+
+namespace traits
+{
+
+/**
+ * A type trait to identify is the type a range, but not a contiguous container of fundamentals:
+ * std::deque, std::list, std::set...
+ */
+template<typename T, typename = void>
+struct is_noncontiguous_range : std::false_type
+{
+};
+
+template<typename T>
+struct is_noncontiguous_range<T, void_t<decltype(std::begin(std::declval<const T&>())),
+                                        decltype(std::end(std::declval<const T&>()))>>
+        : std::integral_constant<bool, !is_ra_fundamental_container<T>::value>
+{
+};
+
+/**
+ * A type trait to identify is the type a range of fundamentals hashed by the bytes of its elements
+ */
+template<typename T, typename = void>
+struct is_noncontiguous_fundamental_range : std::false_type
+{
+};
+
+template<typename T>
+struct is_noncontiguous_fundamental_range<T, void_t<typename T::value_type>>
+        : std::integral_constant<bool, is_noncontiguous_range<T>::value
+                                       && std::is_fundamental<typename T::value_type>::value>
+{
+};
+
+} // namespace traits
+
+/**
+ * hash_append(hasher, value) feeds a value into an incremental hasher, anything with update(data, length).
+ * Fundamentals are fed by their bytes. Containers and ranges are fed by their elements followed by their size,
+ * so ("ab", "c") and ("a", "bc") differ. Pairs and tuples are fed by their elements.
+ * To make a struct hashable, declare hash_append for it in its namespace, it is found by ADL:
+ *
+ *     template<typename Hasher>
+ *     void hash_append(Hasher& hasher, const point& value) noexcept
+ *     {
+ *         hll::hash_append_fields(hasher, value.x, value.y);
+ *     }
+ */
+
+template<typename Hasher, typename T, typename std::enable_if<std::is_fundamental<T>::value>::type* = nullptr>
+void hash_append(Hasher& hasher, const T& value) noexcept;
+
+template<typename Hasher, typename T,
+        typename std::enable_if<traits::is_ra_fundamental_container<T>::value>::type* = nullptr>
+void hash_append(Hasher& hasher, const T& value) noexcept;
+
+template<typename Hasher, typename T, typename std::enable_if<traits::is_noncontiguous_range<T>::value>::type* = nullptr>
+void hash_append(Hasher& hasher, const T& value) noexcept;
+
+template<typename Hasher, typename First, typename Second>
+void hash_append(Hasher& hasher, const std::pair<First, Second>& value) noexcept;
+
+template<typename Hasher, typename... Ts>
+void hash_append(Hasher& hasher, const std::tuple<Ts...>& value) noexcept;
+
+template<typename Hasher>
+void hash_append(Hasher& hasher, const byte_segments& value) noexcept;
+
+/**
+ * Feed the fields of a struct one after another
+ * @param hasher the hasher
+ * @param fields the fields
+ */
+template<typename Hasher, typename... Ts>
+void hash_append_fields(Hasher& hasher, const Ts& ... fields) noexcept
+{
+    // a braced list evaluates left to right
+    const int sequence[] = {0, (hash_append(hasher, fields), 0)...};
+    (void) sequence;
+}
+
+template<typename Hasher, typename T, typename std::enable_if<std::is_fundamental<T>::value>::type*>
+void hash_append(Hasher& hasher, const T& value) noexcept
+{
+    hasher.update(&value, sizeof(T));
+}
+
+template<typename Hasher, typename T, typename std::enable_if<traits::is_ra_fundamental_container<T>::value>::type*>
+void hash_append(Hasher& hasher, const T& value) noexcept
+{
+    hasher.update(value.data(), value.size() * sizeof(typename T::value_type));
+    hash_append(hasher, static_cast<uint64_t>(value.size()));
+}
+
+template<typename Hasher, typename T, typename std::enable_if<traits::is_noncontiguous_range<T>::value>::type*>
+void hash_append(Hasher& hasher, const T& value) noexcept
+{
+    uint64_t size = 0;
+    for (const auto& element : value)
+    {
+        hash_append(hasher, element);
+        ++size;
+    }
+    hash_append(hasher, size);
+}
+
+template<typename Hasher, typename First, typename Second>
+void hash_append(Hasher& hasher, const std::pair<First, Second>& value) noexcept
+{
+    hash_append_fields(hasher, value.first, value.second);
+}
+
+namespace details
+{
+
+template<typename Hasher, typename Tuple, std::size_t... Is>
+void hash_append_tuple(Hasher& hasher, const Tuple& value, traits::index_sequence<Is...>) noexcept
+{
+    hash_append_fields(hasher, std::get<Is>(value)...);
+}
+
+} // namespace details
+
+template<typename Hasher, typename... Ts>
+void hash_append(Hasher& hasher, const std::tuple<Ts...>& value) noexcept
+{
+    details::hash_append_tuple(hasher, value, traits::make_index_sequence<sizeof...(Ts)>{});
+}
+
+template<typename Hasher>
+void hash_append(Hasher& hasher, const byte_segments& value) noexcept
+{
+    uint64_t size = 0;
+    for (std::size_t i = 0; i < value.count; ++i)
+    {
+        hasher.update(value.segments[i].data, value.segments[i].size);
+        size += value.segments[i].size;
+    }
+    hash_append(hasher, size);
+}
+
+namespace traits
+{
+
+/**
+ * A type trait to identify can the value be fed into an incremental hasher: a hash_append overload is visible
+ */
+template<typename T, typename = void>
+struct is_hash_appendable : std::false_type
+{
+};
+
+template<typename T>
+struct is_hash_appendable<T, void_t<decltype(hash_append(std::declval<murmur3_hasher&>(), std::declval<const T&>()))>>
+        : std::true_type
+{
+};
+
+} // namespace traits
+} // namespace hll
+
+#endif //HLL_HASH_APPEND_HXX
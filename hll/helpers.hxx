@@ -7,11 +7,52 @@
 #define HYPER_LOG_LOG_HELPERS_HXX
 
 #include <array>
+#include <cstdint>
 #include <type_traits> // std::is_nothrow_copy_assignable
-#include "details.hxx" // HLL_CONSTEXPR_OR_INLINE
+#include "details.hxx" // HLL_CONSTEXPR_OR_INLINE, HLL_IS_CONSTANT_EVALUATED
+
+#if defined(_MSC_VER) && !defined(__GNUC__)
+#include <intrin.h> // _BitScanForward
+#endif
 
 namespace hll
 {
+namespace details
+{
+
+/// positions of the bits by the de Bruijn sequences
+template<typename = void>
+struct de_bruijn
+{
+    static constexpr uint8_t positions32[32] = {
+            0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+            31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9};
+    static constexpr uint8_t positions64[64] = {
+            0, 1, 48, 2, 57, 49, 28, 3, 61, 58, 50, 42, 38, 29, 17, 4,
+            62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12, 5,
+            63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+            46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19, 9, 13, 8, 7, 6};
+};
+
+template<typename Dummy>
+constexpr uint8_t de_bruijn<Dummy>::positions32[32];
+
+template<typename Dummy>
+constexpr uint8_t de_bruijn<Dummy>::positions64[64];
+
+/// the lowest set bit multiplied by the de Bruijn sequence has a unique pattern in its top bits
+HLL_CONSTEXPR_OR_INLINE uint32_t countr_zero_de_bruijn(uint32_t value) noexcept
+{
+    return de_bruijn<>::positions32[((value & (0u - value)) * 0x077cb531u) >> 27u];
+}
+
+HLL_CONSTEXPR_OR_INLINE uint32_t countr_zero_de_bruijn(uint64_t value) noexcept
+{
+    return de_bruijn<>::positions64[((value & (0ull - value)) * 0x03f79d71b4cb0a89ull) >> 58u];
+}
+
+} // namespace details
+
 namespace helpers
 {
 
@@ -31,6 +72,47 @@ array_fill(std::array<T, N>& array, const T& filler) noexcept(std::is_nothrow_co
     }
 }
 
+/**
+ * Count the trailing zero bits, like C++20 std::countr_zero, by one instruction where the compiler has one:
+ * bsf or tzcnt on x86. Falls back to a de Bruijn multiplication, also in constant expressions on MSVC
+ * @param value the value, must not be zero
+ * @return the number of the trailing zero bits
+ */
+HLL_CONSTEXPR_OR_INLINE uint32_t countr_zero(uint32_t value) noexcept
+{
+#if defined(__GNUC__)
+    return static_cast<uint32_t>(__builtin_ctz(value));
+#elif defined(_MSC_VER)
+    if (HLL_IS_CONSTANT_EVALUATED())
+        return details::countr_zero_de_bruijn(value);
+    unsigned long index = 0;
+    _BitScanForward(&index, value);
+    return static_cast<uint32_t>(index);
+#else
+    return details::countr_zero_de_bruijn(value);
+#endif
+}
+
+/**
+ * Count the trailing zero bits of a 64-bit value
+ * @param value the value, must not be zero
+ * @return the number of the trailing zero bits
+ */
+HLL_CONSTEXPR_OR_INLINE uint32_t countr_zero(uint64_t value) noexcept
+{
+#if defined(__GNUC__)
+    return static_cast<uint32_t>(__builtin_ctzll(value));
+#elif defined(_MSC_VER) && defined(_M_X64)
+    if (HLL_IS_CONSTANT_EVALUATED())
+        return details::countr_zero_de_bruijn(value);
+    unsigned long index = 0;
+    _BitScanForward64(&index, value);
+    return static_cast<uint32_t>(index);
+#else
+    return details::countr_zero_de_bruijn(value);
+#endif
+}
+
 } // namespace helpers
 } // namespace hll
 
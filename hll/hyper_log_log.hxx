@@ -6,22 +6,228 @@
 #ifndef HYPER_LOG_LOG_HXX
 #define HYPER_LOG_LOG_HXX
 
-#include <algorithm> // std::count
+#include <algorithm> // std::max
 #include <array>
 #include <cmath> // std::log
+#include <initializer_list>
+#include <iterator> // std::iterator_traits
+#include <type_traits>
 #include "hash.hxx"
-#include "helpers.hxx" // hll::helpers::max, hll::helpers::array_fill
+#include "kernels.hxx"
+#include "helpers.hxx" // hll::helpers::max, hll::helpers::array_fill, hll::helpers::countr_zero
 #include "details.hxx" // HLL_CONSTEXPR_OR_INLINE
 
 namespace hll
 {
 
+namespace details
+{
+
+/// index of the register the hash selects: 32-bit hashes select it by their high k bits, 64-bit ones by their low k bits
+constexpr uint32_t register_index(uint32_t hash_value, std::size_t k) noexcept
+{
+    return hash_value >> (32 - k);
+}
+
+constexpr uint32_t register_index(uint64_t hash_value, std::size_t k) noexcept
+{
+    return static_cast<uint32_t>(hash_value & ((static_cast<uint64_t>(1) << k) - 1));
+}
+
+/// the number of the trailing zeros of the bits left over from the index, capped by their width, plus one,
+/// the bit set past them caps the count without a branch and makes the value non-zero
+HLL_CONSTEXPR_OR_INLINE uint32_t register_rank(uint32_t hash_value, std::size_t k) noexcept
+{
+    return hll::helpers::countr_zero(hash_value | (1u << (32 - k))) + 1;
+}
+
+HLL_CONSTEXPR_OR_INLINE uint32_t register_rank(uint64_t hash_value, std::size_t k) noexcept
+{
+    return hll::helpers::countr_zero((hash_value >> k) | (static_cast<uint64_t>(1) << (64 - k))) + 1;
+}
+
+/**
+ * Merge the registers of a sketch of precision k into the registers of a sketch of a lower precision k2,
+ * as if the hashes were added at k2 in the first place: the index bits dropped by k2 become rank bits.
+ * 32-bit hashes keep their rank unless it is capped at k, then it continues into the dropped bits;
+ * 64-bit hashes take the rank of the dropped bits unless they are all zeros, then the rank grows by k - k2
+ * @tparam HashResult uint32_t or uint64_t, selects the register layout
+ * @param source 2^k registers
+ * @param k precision of the source
+ * @param target 2^k2 registers, updated in place
+ * @param k2 precision of the target, not greater than k
+ */
+template<typename HashResult>
+HLL_CONSTEXPR_OR_INLINE void fold_registers(const int8_t* source, std::size_t k, int8_t* target, std::size_t k2) noexcept
+{
+    const auto dropped_bits = k - k2;
+    const auto source_count = static_cast<uint32_t>(1) << k;
+    const auto saturated_rank = static_cast<uint32_t>(32 - k + 1);
+    for (uint32_t index = 0; index < source_count; ++index)
+    {
+        auto rank = static_cast<uint32_t>(source[index]);
+        if (rank == 0)
+            continue;
+
+        uint32_t target_index = 0;
+        if (sizeof(HashResult) == 4)
+        {
+            target_index = index >> dropped_bits;
+            if (rank == saturated_rank)
+            {
+                const auto dropped = index & ((static_cast<uint32_t>(1) << dropped_bits) - 1);
+                rank += hll::helpers::countr_zero(dropped | (static_cast<uint32_t>(1) << dropped_bits));
+            }
+        } else
+        {
+            target_index = index & ((static_cast<uint32_t>(1) << k2) - 1);
+            const auto dropped = index >> k2;
+            rank = dropped != 0 ? hll::helpers::countr_zero(dropped) + 1 : rank + static_cast<uint32_t>(dropped_bits);
+        }
+        if (static_cast<uint32_t>(target[target_index]) < rank)
+            target[target_index] = static_cast<int8_t>(rank);
+    }
+}
+
+constexpr double alpha_m(std::size_t registers_count) noexcept
+{
+    return registers_count == 16
+           ? 0.673
+           : registers_count == 32
+             ? 0.697
+             : registers_count == 64
+               ? 0.709
+               : 0.7213 /
+                 (1.0 + 1.079 / registers_count);
+}
+
+/**
+ * Estimate the cardinality from the registers
+ * @param sums the sum of 2^-register and the number of the zero registers
+ * @param registers_count number of the registers
+ * @param hash_bits number of bits of the hash values
+ * @return the estimate
+ */
+HLL_CONSTEXPR_OR_INLINE std::size_t estimate_cardinality(hll::kernels::register_sum sums, std::size_t registers_count,
+                                                         std::size_t hash_bits)
+{
+    constexpr double TWO_32_POWER = 0x100000000;
+    const auto count = sums.sum;
+
+    // Оценка количества элементов
+    auto estimation = alpha_m(registers_count) * registers_count * registers_count / count;
+
+    // корректировка результатов в зависимости от размеров оценки
+    if (estimation <= 2.5 * registers_count)
+    {
+        const auto zero_registers_count = sums.zeros;
+
+        if (zero_registers_count > 0)
+            // если хотя бы один регистр "пустой", то используем linear counting
+            estimation = registers_count * std::log(static_cast<double>(registers_count) / zero_registers_count);
+    } else if (hash_bits == 32 && estimation > (TWO_32_POWER / 30.0))
+    { // если оценка получилась довольно большой
+        estimation = -TWO_32_POWER * std::log(1.0 - (estimation / TWO_32_POWER));
+    }
+
+    return static_cast<std::size_t>(estimation);
+}
+
+/// the elements of the range, without cv-qualifiers
+template<typename InputIt>
+using range_element = typename std::remove_cv<typename std::iterator_traits<InputIt>::value_type>::type;
+
+/// contiguous containers given by reference that hash as T without conversion, their bytes can be hashed by the batch
+template<typename Hash, typename T, typename InputIt>
+using batch_hashable = std::integral_constant<bool,
+        hll::traits::has_hash_batch<Hash>::value
+        && hll::traits::is_ra_fundamental_container<range_element<InputIt>>::value
+        && std::is_lvalue_reference<typename std::iterator_traits<InputIt>::reference>::value
+        && (std::is_same<T, range_element<InputIt>>::value
+            || hll::traits::is_heterogeneous_key_for<Hash, T, range_element<InputIt>>::value)>;
+
+/// hash an element hashing as T without conversion, as add(const U&) does
+template<typename T, typename Hash, typename U>
+typename Hash::result_type hash_element(const Hash& hash, const U& value, std::true_type)
+{
+    return hash(as_key(value));
+}
+
+/// hash an element converted to T, as add(const T&) does
+template<typename T, typename Hash>
+typename Hash::result_type hash_element(const Hash& hash, const T& value, std::false_type)
+{
+    return hash(value);
+}
+
+template<typename Hash, typename T, typename InputIt, typename AddHashes>
+void hash_blocks(InputIt first, InputIt last, AddHashes add_hashes, std::false_type)
+{
+    using heterogeneous = hll::traits::is_heterogeneous_key_for<Hash, T, range_element<InputIt>>;
+    constexpr std::size_t block_size = 64;
+    const Hash hash{};
+    typename Hash::result_type hashes[block_size];
+    while (first != last)
+    {
+        std::size_t count = 0;
+        for (; count < block_size && first != last; ++count, ++first)
+        {
+            hashes[count] = hash_element<T>(hash, *first, heterogeneous{});
+        }
+        add_hashes(hashes, count);
+    }
+}
+
+template<typename Hash, typename T, typename InputIt, typename AddHashes>
+void hash_blocks(InputIt first, InputIt last, AddHashes add_hashes, std::true_type)
+{
+    using element_type = typename std::iterator_traits<InputIt>::value_type::value_type;
+    constexpr std::size_t block_size = 64;
+    const Hash hash{};
+    const void* keys[block_size];
+    std::size_t lengths[block_size];
+    typename Hash::result_type hashes[block_size];
+    while (first != last)
+    {
+        std::size_t count = 0;
+        for (; count < block_size && first != last; ++count, ++first)
+        {
+            const auto& value = *first;
+            keys[count] = value.data();
+            lengths[count] = value.size() * sizeof(element_type);
+        }
+        hash.hash_batch(keys, lengths, count, hashes);
+        add_hashes(hashes, count);
+    }
+}
+
+/**
+ * Hash the elements in blocks and pass every block to add_hashes(const Hash::result_type* hashes, std::size_t count).
+ * Every element hashes as a sketch of T adding it alone would hash it: converted to T,
+ * unless it hashes as T without conversion, like a std::string_view does for std::string
+ * @tparam T the type of values of the sketch
+ * @param first the first element
+ * @param last past the last element
+ * @param add_hashes the function object updating the registers
+ */
+template<typename Hash, typename T, typename InputIt, typename AddHashes>
+void hash_blocks(InputIt first, InputIt last, AddHashes add_hashes)
+{
+    hash_blocks<Hash, T>(first, last, add_hashes, batch_hashable<Hash, T, InputIt>{});
+}
+
+} // namespace details
+
 /**
  * @brief HyperLogLog C++11 generic implementation
  * @tparam T the type of values
  * @tparam k number that controls number of registers as 2^k
+ * @tparam Hash hash policy, a stateless function object with result_type member type of uint32_t or uint64_t,
+ * callable with const T&. Plug in a faster hash, one reading a precomputed hash out of the value
+ * or one hashing the fields of a struct. 32-bit hashes select a register by their high k bits,
+ * 64-bit hashes - by their low k bits as Redis does
  */
-template<typename T, std::size_t k>
+template<typename T, std::size_t k, typename Hash = hll::murmur3_hash>
 class hyper_log_log
 {
 public:
@@ -31,28 +237,21 @@ public:
     /// type of size values
     using size_type = size_t;
     using value_type = T;
+    using hasher = Hash;
+    using hash_result_type = typename Hash::result_type;
     using this_type = hyper_log_log;
     static constexpr size_type registers_count = 1u << k;
+    /// number of bits of the hash values
+    static constexpr size_type hash_bits = sizeof(hash_result_type) * 8;
+    /// type of the registers' storage
+    using container_type = std::array<register_type, registers_count>;
 
 private:
-    static constexpr double get_alpha_m() noexcept
-    {
-        return registers_count == 16
-               ? 0.673
-               : registers_count == 32
-                 ? 0.697
-                 : registers_count == 64
-                   ? 0.709
-                   : 0.7213 /
-                     (1.0 + 1.079 / registers_count);
-    }
-
-    static HLL_CONSTEXPR_OR_INLINE uint32_t count_bits(hash_result value) noexcept;
+    static_assert(std::is_same<hash_result_type, uint32_t>::value || std::is_same<hash_result_type, uint64_t>::value,
+                  "Hash::result_type must be uint32_t or uint64_t");
+    static_assert(hll::traits::is_hash_policy_for<Hash, T>::value,
+                  "Hash must be callable with const T& and return Hash::result_type");
 
-    static constexpr auto k_alternative = static_cast<uint8_t>(32 - k);
-    static constexpr auto alpha_m_squared = get_alpha_m() * registers_count * registers_count;
-
-    using container_type = std::array<register_type, registers_count>;
     container_type m_registers{};
 public:
     /**
@@ -67,6 +266,67 @@ public:
      */
     HLL_CONSTEXPR_OR_INLINE void add(const value_type& value);
 
+    /**
+     * Add an element given as another type hashing the same as value_type does, without converting it:
+     * e.g. a std::string_view, a character array or a C string to a sketch of std::string
+     * @param value the element
+     */
+    template<typename U, typename std::enable_if<
+            hll::traits::is_heterogeneous_key_for<Hash, T, U>::value>::type* = nullptr>
+    HLL_CONSTEXPR_OR_INLINE void add(const U& value)
+    {
+        add_hash(Hash{}(hll::details::as_key(value)));
+    }
+
+    /**
+     * Add elements, hashing them in blocks before updating the registers
+     * @param first the first element
+     * @param last past the last element
+     */
+    template<typename InputIt>
+    void add(InputIt first, InputIt last);
+
+    /**
+     * Add an element by its hash, e.g. a fingerprint computed upstream.
+     * The hash must be produced by the same function as Hash produces, or sketches will not merge properly
+     * @param hash_value the hash of the element
+     */
+    HLL_CONSTEXPR_OR_INLINE void add_hash(hash_result_type hash_value) noexcept;
+
+    /**
+     * Add elements by their hashes
+     * @param hashes the hashes of the elements
+     * @param count number of the hashes
+     */
+    HLL_CONSTEXPR_OR_INLINE void add_hashes(const hash_result_type* hashes, size_type count) noexcept;
+
+    /**
+     * Get the registers of the data structure
+     * @return registers
+     */
+    constexpr const container_type& registers() const noexcept
+    {
+        return m_registers;
+    }
+
+    /**
+     * Get the registers of the data structure, e.g. to load them from a serialized form
+     * @return registers
+     */
+    HLL_CONSTEXPR_OR_INLINE container_type& registers() noexcept
+    {
+        return m_registers;
+    }
+
+    /**
+     * Get the hash policy
+     * @return the hash function object
+     */
+    constexpr hasher hash_function() const noexcept
+    {
+        return hasher{};
+    }
+
     /**
      * Get relative error of the data structure
      * @return - the error
@@ -91,6 +351,22 @@ public:
      */
     HLL_CONSTEXPR_OR_INLINE this_type&
     merge(const this_type& rhs) noexcept(noexcept(helpers::max<register_type>({}, {})));
+    /**
+     * Merge a sketch of a higher precision, folding its registers into this precision on the fly
+     * @param rhs A HyperLogLog instance of precision k2 to merge with
+     * @return this reference
+     */
+    template<std::size_t k2>
+    HLL_CONSTEXPR_OR_INLINE this_type& merge(const hyper_log_log<T, k2, Hash>& rhs) noexcept;
+
+    /**
+     * Fold the sketch into a lower precision, the result equals the sketch of the same values made at k2
+     * @tparam k2 the precision, not greater than k
+     * @return the folded sketch
+     */
+    template<std::size_t k2>
+    HLL_CONSTEXPR_OR_INLINE hyper_log_log<T, k2, Hash> fold() const noexcept;
+
     /**
      * HyperLogLog's merge operator overload
      * @param rhs A HyperLogLog instance to merge with
@@ -105,82 +381,63 @@ public:
     HLL_CONSTEXPR_OR_INLINE this_type operator+(const this_type& rhs) const noexcept(noexcept(merge(rhs)));
 };
 
-template<typename T, std::size_t k>
-HLL_CONSTEXPR_OR_INLINE uint32_t hyper_log_log<T, k>::count_bits(hash_result value) noexcept
+template<typename T, std::size_t k, typename Hash>
+HLL_CONSTEXPR_OR_INLINE auto hyper_log_log<T, k, Hash>::count() const
+-> typename hyper_log_log<T, k, Hash>::size_type
 {
-    if ((value & 1u) == 1)
-        return 0;
-
-    uint32_t c = 1;
-    if ((value & 0xffffu) == 0)
-    {
-        value >>= 16u;
-        c += 16;
-    }
-    if ((value & 0xffu) == 0)
-    {
-        value >>= 8u;
-        c += 8;
-    }
-    if ((value & 0xfu) == 0)
-    {
-        value >>= 4u;
-        c += 4;
-    }
-    if ((value & 0x3u) == 0)
-    {
-        value >>= 2u;
-        c += 2;
-    }
-    c -= value & 0x1u;
-
-    return c;
+    const auto sums = HLL_IS_CONSTANT_EVALUATED()
+                      ? hll::details::sum_registers_scalar(m_registers.data(), registers_count)
+                      : hll::kernels::active().sum(m_registers.data(), registers_count);
+    return hll::details::estimate_cardinality(sums, registers_count, hash_bits);
 }
 
-
-template<typename T, std::size_t k>
-HLL_CONSTEXPR_OR_INLINE auto hyper_log_log<T, k>::count() const
--> typename hyper_log_log<T, k>::size_type
+template<typename T, std::size_t k, typename Hash>
+HLL_CONSTEXPR_OR_INLINE void hyper_log_log<T, k, Hash>::add(const value_type& value)
 {
-    constexpr double TWO_32_POWER = 0x100000000;
-    double count = 0;
+    add_hash(Hash{}(value));
+}
 
-    for (const auto& element : m_registers)
-        count += 1.0 / (1u << element);
+template<typename T, std::size_t k, typename Hash>
+template<typename InputIt>
+void hyper_log_log<T, k, Hash>::add(InputIt first, InputIt last)
+{
+    hll::details::hash_blocks<Hash, T>(first, last, [this](const hash_result_type* hashes, size_type count)
+    {
+        add_hashes(hashes, count);
+    });
+}
 
-    // Оценка количества элементов
-    auto estimation = alpha_m_squared / count;
+template<typename T, std::size_t k, typename Hash>
+HLL_CONSTEXPR_OR_INLINE void hyper_log_log<T, k, Hash>::add_hashes(const hash_result_type* hashes, size_type count)
+noexcept
+{
+    if (!HLL_IS_CONSTANT_EVALUATED() && hll::kernels::add_hashes(m_registers.data(), hashes, count, k))
+        return;
 
-    // корректировка результатов в зависимости от размеров оценки
-    if (estimation <= 2.5 * registers_count)
+    for (size_type i = 0; i < count; ++i)
     {
-        const auto zero_registers_count = std::count(m_registers.begin(), m_registers.end(), 0);
-
-        if (zero_registers_count > 0)
-            // если хотя бы один регистр "пустой", то используем linear counting
-            estimation = registers_count * std::log(static_cast<double>(registers_count) / zero_registers_count);
-    } else if (estimation > (TWO_32_POWER / 30.0))
-    { // если оценка получилась довольно большой
-        estimation = -TWO_32_POWER * std::log(1.0 - (estimation / TWO_32_POWER));
+        add_hash(hashes[i]);
     }
-
-    return static_cast<size_type>(estimation);
 }
 
-template<typename T, std::size_t k>
-HLL_CONSTEXPR_OR_INLINE void hyper_log_log<T, k>::add(const value_type& value)
+template<typename T, std::size_t k, typename Hash>
+HLL_CONSTEXPR_OR_INLINE void hyper_log_log<T, k, Hash>::add_hash(hash_result_type hash_value) noexcept
 {
-    const auto hash_value = hll::hash(value);
-    const auto index = hash_value >> k_alternative;
-    const auto bits_count = count_bits(hash_value);
-    const auto rank = std::min(static_cast<uint32_t>(k_alternative), bits_count) + 1;
+    const auto index = hll::details::register_index(hash_value, k);
+    const auto rank = hll::details::register_rank(hash_value, k);
     m_registers[index] = static_cast<register_type>(std::max(static_cast<uint32_t>(m_registers[index]), rank));
 }
 
-template<typename T, std::size_t k>
-HLL_CONSTEXPR_OR_INLINE hyper_log_log<T, k>& hyper_log_log<T, k>::merge(const hyper_log_log::this_type& rhs)
+template<typename T, std::size_t k, typename Hash>
+HLL_CONSTEXPR_OR_INLINE hyper_log_log<T, k, Hash>& hyper_log_log<T, k, Hash>::merge(const hyper_log_log::this_type& rhs)
 noexcept(noexcept(helpers::max<register_type>({}, {})))
 {
+    if (!HLL_IS_CONSTANT_EVALUATED())
+    {
+        hll::kernels::active().merge(m_registers.data(), rhs.m_registers.data(), registers_count);
+        return *this;
+    }
+
     for (auto i = 0u; i < registers_count; ++i)
     {
         m_registers[i] = hll::helpers::max(m_registers[i], rhs.m_registers[i]);
@@ -188,18 +445,38 @@ noexcept(noexcept(helpers::max<register_type>({}, {})))
     return *this;
 }
 
-template<typename T, std::size_t k>
-HLL_CONSTEXPR_OR_INLINE hyper_log_log<T, k>&
-hyper_log_log<T, k>::operator+=(const typename hyper_log_log::this_type& rhs)
+template<typename T, std::size_t k, typename Hash>
+template<std::size_t k2>
+HLL_CONSTEXPR_OR_INLINE hyper_log_log<T, k, Hash>& hyper_log_log<T, k, Hash>::merge(const hyper_log_log<T, k2, Hash>& rhs)
+noexcept
+{
+    static_assert(k2 >= k, "only a sketch of a higher precision can be folded into this one");
+    hll::details::fold_registers<hash_result_type>(rhs.registers().data(), k2, m_registers.data(), k);
+    return *this;
+}
+
+template<typename T, std::size_t k, typename Hash>
+template<std::size_t k2>
+HLL_CONSTEXPR_OR_INLINE hyper_log_log<T, k2, Hash> hyper_log_log<T, k, Hash>::fold() const noexcept
+{
+    static_assert(k2 <= k, "a sketch can be folded into a lower precision only");
+    hyper_log_log<T, k2, Hash> result{};
+    hll::details::fold_registers<hash_result_type>(m_registers.data(), k, result.registers().data(), k2);
+    return result;
+}
+
+template<typename T, std::size_t k, typename Hash>
+HLL_CONSTEXPR_OR_INLINE hyper_log_log<T, k, Hash>&
+hyper_log_log<T, k, Hash>::operator+=(const typename hyper_log_log::this_type& rhs)
 noexcept(noexcept(merge(rhs)))
 {
     this->merge(rhs);
     return *this;
 }
 
-template<typename T, std::size_t k>
-HLL_CONSTEXPR_OR_INLINE hyper_log_log<T, k>
-hyper_log_log<T, k>::operator+(const typename hyper_log_log::this_type& rhs) const
+template<typename T, std::size_t k, typename Hash>
+HLL_CONSTEXPR_OR_INLINE hyper_log_log<T, k, Hash>
+hyper_log_log<T, k, Hash>::operator+(const typename hyper_log_log::this_type& rhs) const
 noexcept(noexcept(merge(rhs)))
 {
     this_type res = *this;
@@ -207,5 +484,71 @@ noexcept(noexcept(merge(rhs)))
     return res;
 }
 
+/**
+ * Make a sketch of the values, at compile time since C++17 if the hash is constexpr:
+ * murmur3_hash and murmur64a_hash are for integers and characters. E.g. a sketch of a static dictionary
+ * is built into the binary and merged into the runtime sketches with no startup cost:
+ *
+ *     constexpr auto bots = hll::make_hyper_log_log<std::string_view, 12>({"Googlebot", "bingbot", "YandexBot"});
+ *
+ * @tparam T the type of values
+ * @tparam k number that controls number of registers as 2^k
+ * @tparam Hash hash policy
+ * @param values the values, of type T or any other type add takes
+ * @return the sketch
+ */
+template<typename T, std::size_t k, typename Hash = hll::murmur3_hash, typename U>
+HLL_CONSTEXPR_OR_INLINE hyper_log_log<T, k, Hash> make_hyper_log_log(std::initializer_list<U> values)
+{
+    hyper_log_log<T, k, Hash> result{};
+    for (const auto& value : values)
+    {
+        result.add(value);
+    }
+    return result;
+}
+
+/**
+ * Add an element to several sketches hashing it once, e.g. an event to the global, per-region and per-hour sketches.
+ * Sketches of different precisions take their registers from the same hash as their own add would,
+ * so each of them ends up as if the element was added to it alone
+ * @param value the element
+ * @param sketch a sketch, hyper_log_log or dynamic_hyper_log_log
+ * @param sketches more sketches of the same hash policy, of any precisions
+ */
+template<typename Sketch, typename... Sketches, typename = typename Sketch::hasher>
+HLL_CONSTEXPR_OR_INLINE void add_all(const typename Sketch::value_type& value, Sketch& sketch, Sketches& ... sketches)
+{
+    static_assert(hll::traits::are_same<typename Sketch::hasher, typename Sketches::hasher...>::value,
+                  "the sketches must have the same hash policy");
+    const auto hash_value = typename Sketch::hasher{}(value);
+    sketch.add_hash(hash_value);
+    const int sequence[] = {0, (sketches.add_hash(hash_value), 0)...};
+    (void) sequence;
+}
+
+/**
+ * Add elements to several sketches hashing them once, in blocks
+ * @param first the first element
+ * @param last past the last element
+ * @param sketch a sketch, hyper_log_log or dynamic_hyper_log_log
+ * @param sketches more sketches of the same hash policy, of any precisions
+ */
+template<typename InputIt, typename Sketch, typename... Sketches, typename = typename Sketch::hasher>
+void add_all(InputIt first, InputIt last, Sketch& sketch, Sketches& ... sketches)
+{
+    static_assert(hll::traits::are_same<typename Sketch::hasher, typename Sketches::hasher...>::value,
+                  "the sketches must have the same hash policy");
+    using hash_result_type = typename Sketch::hash_result_type;
+    using hasher = typename Sketch::hasher;
+    using value_type = typename Sketch::value_type;
+    hll::details::hash_blocks<hasher, value_type>(first, last, [&](const hash_result_type* hashes, std::size_t count)
+    {
+        sketch.add_hashes(hashes, count);
+        const int sequence[] = {0, (sketches.add_hashes(hashes, count), 0)...};
+        (void) sequence;
+    });
+}
+
 } // namespace hll
 #endif //HYPER_LOG_LOG_HXX
@@ -0,0 +1,508 @@
+/**
+ * @file hll/kernels.hxx
+ * @brief Merge, count and batched add kernels over the registers, for every dispatch level
+ * @author Daniil Dudkin (unterumarmung)
+ */
+#ifndef HLL_KERNELS_HXX
+#define HLL_KERNELS_HXX
+
+#include <cstddef>
+#include <cstdint>
+
+#include "details.hxx" // HLL_CONSTEXPR_OR_INLINE, HLL_TARGET, HLL_X86_64
+#include "dispatch.hxx"
+
+#if HLL_X86_64
+#include <immintrin.h>
+#endif
+
+namespace hll
+{
+namespace kernels
+{
+
+/**
+ * Sum of 2^-register over the registers and the number of the zero registers
+ */
+struct register_sum
+{
+    double sum;
+    std::size_t zeros;
+};
+
+} // namespace kernels
+
+namespace details
+{
+
+/*
+ * The sum is accumulated in 16 partial sums, register i goes to the partial i % 16, and the partials are
+ * added pairwise in a fixed order. Every level does exactly the same additions, so count() gives
+ * the same estimate whichever level runs it.
+ */
+constexpr std::size_t register_sum_lanes = 16;
+
+/// 2^-r of every rank a register can hold
+template<typename = void>
+struct inverse_powers_of_two
+{
+    static constexpr double values[64] = {
+            1.0 / (1ull << 0u), 1.0 / (1ull << 1u), 1.0 / (1ull << 2u), 1.0 / (1ull << 3u),
+            1.0 / (1ull << 4u), 1.0 / (1ull << 5u), 1.0 / (1ull << 6u), 1.0 / (1ull << 7u),
+            1.0 / (1ull << 8u), 1.0 / (1ull << 9u), 1.0 / (1ull << 10u), 1.0 / (1ull << 11u),
+            1.0 / (1ull << 12u), 1.0 / (1ull << 13u), 1.0 / (1ull << 14u), 1.0 / (1ull << 15u),
+            1.0 / (1ull << 16u), 1.0 / (1ull << 17u), 1.0 / (1ull << 18u), 1.0 / (1ull << 19u),
+            1.0 / (1ull << 20u), 1.0 / (1ull << 21u), 1.0 / (1ull << 22u), 1.0 / (1ull << 23u),
+            1.0 / (1ull << 24u), 1.0 / (1ull << 25u), 1.0 / (1ull << 26u), 1.0 / (1ull << 27u),
+            1.0 / (1ull << 28u), 1.0 / (1ull << 29u), 1.0 / (1ull << 30u), 1.0 / (1ull << 31u),
+            1.0 / (1ull << 32u), 1.0 / (1ull << 33u), 1.0 / (1ull << 34u), 1.0 / (1ull << 35u),
+            1.0 / (1ull << 36u), 1.0 / (1ull << 37u), 1.0 / (1ull << 38u), 1.0 / (1ull << 39u),
+            1.0 / (1ull << 40u), 1.0 / (1ull << 41u), 1.0 / (1ull << 42u), 1.0 / (1ull << 43u),
+            1.0 / (1ull << 44u), 1.0 / (1ull << 45u), 1.0 / (1ull << 46u), 1.0 / (1ull << 47u),
+            1.0 / (1ull << 48u), 1.0 / (1ull << 49u), 1.0 / (1ull << 50u), 1.0 / (1ull << 51u),
+            1.0 / (1ull << 52u), 1.0 / (1ull << 53u), 1.0 / (1ull << 54u), 1.0 / (1ull << 55u),
+            1.0 / (1ull << 56u), 1.0 / (1ull << 57u), 1.0 / (1ull << 58u), 1.0 / (1ull << 59u),
+            1.0 / (1ull << 60u), 1.0 / (1ull << 61u), 1.0 / (1ull << 62u), 1.0 / (1ull << 63u)};
+};
+
+template<typename Dummy>
+constexpr double inverse_powers_of_two<Dummy>::values[64];
+
+HLL_CONSTEXPR_OR_INLINE double reduce_partial_sums(double* partials) noexcept
+{
+    for (std::size_t width = register_sum_lanes / 2; width > 0; width /= 2)
+    {
+        for (std::size_t i = 0; i < width; ++i)
+        {
+            partials[i] += partials[i + width];
+        }
+    }
+    return partials[0];
+}
+
+HLL_CONSTEXPR_OR_INLINE kernels::register_sum sum_registers_scalar(const int8_t* registers, std::size_t count) noexcept
+{
+    double partials[register_sum_lanes] = {};
+    std::size_t zeros = 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        partials[i % register_sum_lanes] += inverse_powers_of_two<>::values[registers[i]];
+        zeros += registers[i] == 0 ? 1 : 0;
+    }
+    return {reduce_partial_sums(partials), zeros};
+}
+
+inline void merge_registers_scalar(int8_t* target, const int8_t* source, std::size_t count) noexcept
+{
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        target[i] = target[i] < source[i] ? source[i] : target[i];
+    }
+}
+
+#if HLL_X86_64
+
+#if defined(__GNUC__) && !defined(__clang__)
+// the AVX-512 intrinsics of GCC 12 start from an undefined vector and it warns about it
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+/// the bits of 2^-r for 64-bit lanes holding r
+#define HLL_INVERSE_POWER_BITS(prefix, ranks) prefix##_slli_epi64(prefix##_sub_epi64(bias, ranks), 52)
+
+HLL_TARGET("sse4.2,popcnt")
+inline std::size_t count_zero_bytes(__m128i bytes) noexcept
+{
+    const auto zero_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_setzero_si128()));
+    return static_cast<std::size_t>(_mm_popcnt_u32(static_cast<unsigned>(zero_mask)));
+}
+
+HLL_TARGET("sse4.2,popcnt")
+inline kernels::register_sum sum_registers_sse42(const int8_t* registers, std::size_t count) noexcept
+{
+    const auto bias = _mm_set1_epi64x(1023);
+    __m128d sums[register_sum_lanes / 2];
+    for (auto& sum : sums)
+        sum = _mm_setzero_pd();
+    std::size_t zeros = 0;
+    for (std::size_t i = 0; i < count; i += register_sum_lanes)
+    {
+        auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(registers + i));
+        zeros += count_zero_bytes(bytes);
+        for (auto& sum : sums)
+        {
+            const auto ranks = _mm_cvtepi8_epi64(bytes);
+            sum = _mm_add_pd(sum, _mm_castsi128_pd(HLL_INVERSE_POWER_BITS(_mm, ranks)));
+            bytes = _mm_srli_si128(bytes, 2);
+        }
+    }
+    // the additions of reduce_partial_sums
+    for (std::size_t width = 4; width > 0; width /= 2)
+    {
+        for (std::size_t j = 0; j < width; ++j)
+            sums[j] = _mm_add_pd(sums[j], sums[j + width]);
+    }
+    return {_mm_cvtsd_f64(_mm_add_sd(sums[0], _mm_unpackhi_pd(sums[0], sums[0]))), zeros};
+}
+
+HLL_TARGET("avx2,popcnt")
+inline kernels::register_sum sum_registers_avx2(const int8_t* registers, std::size_t count) noexcept
+{
+    const auto bias = _mm256_set1_epi64x(1023);
+    __m256d sums[register_sum_lanes / 4];
+    for (auto& sum : sums)
+        sum = _mm256_setzero_pd();
+    std::size_t zeros = 0;
+    for (std::size_t i = 0; i < count; i += register_sum_lanes)
+    {
+        auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(registers + i));
+        zeros += count_zero_bytes(bytes);
+        for (auto& sum : sums)
+        {
+            const auto ranks = _mm256_cvtepi8_epi64(bytes);
+            sum = _mm256_add_pd(sum, _mm256_castsi256_pd(HLL_INVERSE_POWER_BITS(_mm256, ranks)));
+            bytes = _mm_srli_si128(bytes, 4);
+        }
+    }
+    // the additions of reduce_partial_sums
+    const auto half = _mm256_add_pd(_mm256_add_pd(sums[0], sums[2]), _mm256_add_pd(sums[1], sums[3]));
+    const auto quarter = _mm_add_pd(_mm256_castpd256_pd128(half), _mm256_extractf128_pd(half, 1));
+    return {_mm_cvtsd_f64(_mm_add_sd(quarter, _mm_unpackhi_pd(quarter, quarter))), zeros};
+}
+
+HLL_TARGET("avx512f,avx512bw,popcnt")
+inline kernels::register_sum sum_registers_avx512(const int8_t* registers, std::size_t count) noexcept
+{
+    const auto bias = _mm512_set1_epi64(1023);
+    __m512d sums[register_sum_lanes / 8];
+    for (auto& sum : sums)
+        sum = _mm512_setzero_pd();
+    std::size_t zeros = 0;
+    for (std::size_t i = 0; i < count; i += register_sum_lanes)
+    {
+        auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(registers + i));
+        zeros += count_zero_bytes(bytes);
+        for (auto& sum : sums)
+        {
+            const auto ranks = _mm512_cvtepi8_epi64(bytes);
+            sum = _mm512_add_pd(sum, _mm512_castsi512_pd(HLL_INVERSE_POWER_BITS(_mm512, ranks)));
+            bytes = _mm_srli_si128(bytes, 8);
+        }
+    }
+    // the additions of reduce_partial_sums
+    const auto half = _mm512_add_pd(sums[0], sums[1]);
+    const auto quarter = _mm256_add_pd(_mm512_castpd512_pd256(half), _mm512_extractf64x4_pd(half, 1));
+    const auto eighth = _mm_add_pd(_mm256_castpd256_pd128(quarter), _mm256_extractf128_pd(quarter, 1));
+    return {_mm_cvtsd_f64(_mm_add_sd(eighth, _mm_unpackhi_pd(eighth, eighth))), zeros};
+}
+
+#undef HLL_INVERSE_POWER_BITS
+
+HLL_TARGET("sse4.2")
+inline void merge_registers_sse42(int8_t* target, const int8_t* source, std::size_t count) noexcept
+{
+    std::size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        const auto lhs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(target + i));
+        const auto rhs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(target + i), _mm_max_epi8(lhs, rhs));
+    }
+    merge_registers_scalar(target + i, source + i, count - i);
+}
+
+HLL_TARGET("avx2")
+inline void merge_registers_avx2(int8_t* target, const int8_t* source, std::size_t count) noexcept
+{
+    std::size_t i = 0;
+    for (; i + 32 <= count; i += 32)
+    {
+        const auto lhs = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(target + i));
+        const auto rhs = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(target + i), _mm256_max_epi8(lhs, rhs));
+    }
+    merge_registers_sse42(target + i, source + i, count - i);
+}
+
+HLL_TARGET("avx512f,avx512bw")
+inline void merge_registers_avx512(int8_t* target, const int8_t* source, std::size_t count) noexcept
+{
+    std::size_t i = 0;
+    for (; i + 64 <= count; i += 64)
+    {
+        const auto lhs = _mm512_loadu_si512(target + i);
+        const auto rhs = _mm512_loadu_si512(source + i);
+        _mm512_storeu_si512(target + i, _mm512_max_epi8(lhs, rhs));
+    }
+    // small sketches have fewer registers than a vector holds
+    merge_registers_avx2(target + i, source + i, count - i);
+}
+
+/// raise the registers to the ranks computed by the vector code, in the order of the hashes
+template<typename Index, typename Rank>
+inline void update_registers(int8_t* registers, const Index* indexes, const Rank* ranks, std::size_t count) noexcept
+{
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const auto rank = static_cast<int8_t>(ranks[i]);
+        auto& target = registers[indexes[i]];
+        target = target < rank ? rank : target;
+    }
+}
+
+/*
+ * The add kernels compute the register indexes and the ranks of a vector of hashes at once and update
+ * the registers one by one. 32-bit hashes select the register by their high k bits, 64-bit ones by
+ * their low k bits; the rank is the number of the trailing zeros of the rest, capped, plus one.
+ */
+
+HLL_TARGET("avx2")
+inline void add_hashes32_avx2(int8_t* registers, const uint32_t* hashes, std::size_t count, unsigned k) noexcept
+{
+    constexpr std::size_t lanes = 8;
+    const auto index_shift = _mm_cvtsi32_si128(static_cast<int>(32 - k));
+    const auto max_zeros = _mm256_set1_epi32(static_cast<int>(32 - k));
+    const auto one = _mm256_set1_epi32(1);
+    const auto exponent_mask = _mm256_set1_epi32(0xff);
+    const auto exponent_bias = _mm256_set1_epi32(127);
+    uint32_t indexes[lanes];
+    uint32_t ranks[lanes];
+    for (std::size_t i = 0; i < count; i += lanes)
+    {
+        const auto rest = count - i < lanes ? count - i : lanes;
+        __m256i values;
+        if (rest == lanes)
+        {
+            values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(hashes + i));
+        } else
+        {
+            const auto lane_numbers = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+            const auto mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(rest)), lane_numbers);
+            values = _mm256_maskload_epi32(reinterpret_cast<const int*>(hashes + i), mask);
+        }
+        // the lowest set bit converted to float has the number of the trailing zeros in its exponent,
+        // a zero hash gives a negative number, which is above the cap as unsigned
+        const auto lowest_bit = _mm256_and_si256(values, _mm256_sub_epi32(_mm256_setzero_si256(), values));
+        const auto exponent = _mm256_and_si256(_mm256_srli_epi32(_mm256_castps_si256(_mm256_cvtepi32_ps(lowest_bit)), 23),
+                                               exponent_mask);
+        const auto zeros = _mm256_min_epu32(_mm256_sub_epi32(exponent, exponent_bias), max_zeros);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(indexes), _mm256_srl_epi32(values, index_shift));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(ranks), _mm256_add_epi32(zeros, one));
+        update_registers(registers, indexes, ranks, rest);
+    }
+}
+
+/**
+ * Check do two of the 16 lanes hold the same value, comparing every lane with the next 8 ones covers all pairs.
+ * Cheaper than the conflict detection, which is microcoded on Intel cores
+ */
+HLL_TARGET("avx512f")
+inline bool has_equal_lanes(__m512i values) noexcept
+{
+    auto equal = _mm512_cmpeq_epi32_mask(values, _mm512_alignr_epi32(values, values, 1));
+    equal |= _mm512_cmpeq_epi32_mask(values, _mm512_alignr_epi32(values, values, 2));
+    equal |= _mm512_cmpeq_epi32_mask(values, _mm512_alignr_epi32(values, values, 3));
+    equal |= _mm512_cmpeq_epi32_mask(values, _mm512_alignr_epi32(values, values, 4));
+    equal |= _mm512_cmpeq_epi32_mask(values, _mm512_alignr_epi32(values, values, 5));
+    equal |= _mm512_cmpeq_epi32_mask(values, _mm512_alignr_epi32(values, values, 6));
+    equal |= _mm512_cmpeq_epi32_mask(values, _mm512_alignr_epi32(values, values, 7));
+    equal |= _mm512_cmpeq_epi32_mask(values, _mm512_alignr_epi32(values, values, 8));
+    return equal != 0;
+}
+
+/// from this precision on the registers take 32 KiB or more, missing L1, where the scatter update pays off
+constexpr unsigned scatter_min_k = 15;
+
+/**
+ * Raise the registers to the ranks of 16 hashes at once: gather the 4-byte words holding the registers,
+ * raise their bytes and scatter back the words that changed. When two lanes hit the same word, one write
+ * would undo the other, so such vectors are updated one by one. The gathers of the different words overlap
+ * their cache misses, while the scalar updates wait for every miss in turn
+ */
+HLL_TARGET("avx512f,avx512bw")
+inline void update_registers_avx512(int8_t* registers, __m512i indexes, __m512i ranks) noexcept
+{
+    const auto words = _mm512_srli_epi32(indexes, 2);
+    if (has_equal_lanes(words))
+    {
+        uint32_t index_values[16];
+        uint32_t rank_values[16];
+        _mm512_storeu_si512(index_values, indexes);
+        _mm512_storeu_si512(rank_values, ranks);
+        update_registers(registers, index_values, rank_values, 16);
+        return;
+    }
+    const auto shifts = _mm512_slli_epi32(_mm512_and_si512(indexes, _mm512_set1_epi32(3)), 3);
+    // registers are below 128, so their bytes compare as unsigned
+    const auto raised = _mm512_sllv_epi32(ranks, shifts);
+    const auto current = _mm512_i32gather_epi32(words, registers, 4);
+    const auto updated = _mm512_max_epu8(current, raised);
+    _mm512_mask_i32scatter_epi32(registers, _mm512_cmpneq_epi32_mask(updated, current), words, updated, 4);
+}
+
+HLL_TARGET("avx512f,avx512bw,avx512cd")
+inline void add_hashes32_avx512(int8_t* registers, const uint32_t* hashes, std::size_t count, unsigned k) noexcept
+{
+    constexpr std::size_t lanes = 16;
+    const auto index_shift = _mm_cvtsi32_si128(static_cast<int>(32 - k));
+    const auto max_zeros = _mm512_set1_epi32(static_cast<int>(32 - k));
+    const auto one = _mm512_set1_epi32(1);
+    const auto bits = _mm512_set1_epi32(32);
+    uint32_t index_values[lanes];
+    uint32_t rank_values[lanes];
+    for (std::size_t i = 0; i < count; i += lanes)
+    {
+        const auto rest = count - i < lanes ? count - i : lanes;
+        const auto mask = static_cast<__mmask16>((1u << rest) - 1);
+        const auto values = _mm512_maskz_loadu_epi32(mask, hashes + i);
+        // the bits below the lowest set bit, all of them for a zero hash
+        const auto below_lowest = _mm512_andnot_si512(values, _mm512_sub_epi32(values, one));
+        const auto zeros = _mm512_min_epu32(_mm512_sub_epi32(bits, _mm512_lzcnt_epi32(below_lowest)), max_zeros);
+        const auto indexes = _mm512_srl_epi32(values, index_shift);
+        const auto ranks = _mm512_add_epi32(zeros, one);
+        if (k >= scatter_min_k && rest == lanes)
+        {
+            update_registers_avx512(registers, indexes, ranks);
+            continue;
+        }
+        _mm512_storeu_si512(index_values, indexes);
+        _mm512_storeu_si512(rank_values, ranks);
+        update_registers(registers, index_values, rank_values, rest);
+    }
+}
+
+HLL_TARGET("avx512f,avx512bw,avx512cd")
+inline void add_hashes64_avx512(int8_t* registers, const uint64_t* hashes, std::size_t count, unsigned k) noexcept
+{
+    constexpr std::size_t lanes = 16;
+    const auto rank_shift = _mm_cvtsi32_si128(static_cast<int>(k));
+    const auto index_mask = _mm512_set1_epi64(static_cast<long long>((1ull << k) - 1));
+    const auto max_zeros = _mm512_set1_epi64(static_cast<long long>(64 - k));
+    const auto one = _mm512_set1_epi64(1);
+    const auto bits = _mm512_set1_epi64(64);
+    uint32_t index_values[lanes];
+    uint32_t rank_values[lanes];
+    for (std::size_t i = 0; i < count; i += lanes)
+    {
+        const auto rest = count - i < lanes ? count - i : lanes;
+        const auto mask = static_cast<__mmask16>((1u << rest) - 1);
+        __m256i half_indexes[2];
+        __m256i half_ranks[2];
+        for (std::size_t half = 0; half < 2; ++half)
+        {
+            const auto values = _mm512_maskz_loadu_epi64(static_cast<__mmask8>(mask >> (8 * half)),
+                                                         hashes + i + 8 * half);
+            const auto rank_bits = _mm512_srl_epi64(values, rank_shift);
+            const auto below_lowest = _mm512_andnot_si512(rank_bits, _mm512_sub_epi64(rank_bits, one));
+            const auto zeros = _mm512_min_epu64(_mm512_sub_epi64(bits, _mm512_lzcnt_epi64(below_lowest)), max_zeros);
+            half_indexes[half] = _mm512_cvtepi64_epi32(_mm512_and_si512(values, index_mask));
+            half_ranks[half] = _mm512_cvtepi64_epi32(_mm512_add_epi64(zeros, one));
+        }
+        const auto indexes = _mm512_inserti64x4(_mm512_castsi256_si512(half_indexes[0]), half_indexes[1], 1);
+        const auto ranks = _mm512_inserti64x4(_mm512_castsi256_si512(half_ranks[0]), half_ranks[1], 1);
+        if (k >= scatter_min_k && rest == lanes)
+        {
+            update_registers_avx512(registers, indexes, ranks);
+            continue;
+        }
+        _mm512_storeu_si512(index_values, indexes);
+        _mm512_storeu_si512(rank_values, ranks);
+        update_registers(registers, index_values, rank_values, rest);
+    }
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif // HLL_X86_64
+
+} // namespace details
+
+namespace kernels
+{
+
+/**
+ * The kernels of one dispatch level. The add kernels are null where the vector code gives nothing
+ * over the inlined scalar loop
+ */
+struct table
+{
+    /// raise every target register to the source one
+    void (* merge)(int8_t* target, const int8_t* source, std::size_t count) noexcept;
+    /// sum up the registers, count must be a multiple of 16
+    register_sum (* sum)(const int8_t* registers, std::size_t count) noexcept;
+    /// add 32-bit hashes to the 2^k registers
+    void (* add32)(int8_t* registers, const uint32_t* hashes, std::size_t count, unsigned k) noexcept;
+    /// add 64-bit hashes to the 2^k registers
+    void (* add64)(int8_t* registers, const uint64_t* hashes, std::size_t count, unsigned k) noexcept;
+};
+
+/**
+ * Get the kernels of a dispatch level
+ * @param value the level, must be supported by the CPU
+ * @return the kernels
+ */
+inline const table& get(dispatch::level value) noexcept
+{
+    static const table scalar{&details::merge_registers_scalar, &details::sum_registers_scalar, nullptr, nullptr};
+#if HLL_X86_64
+    static const table sse42{&details::merge_registers_sse42, &details::sum_registers_sse42, nullptr, nullptr};
+    static const table avx2{&details::merge_registers_avx2, &details::sum_registers_avx2,
+                            &details::add_hashes32_avx2, nullptr};
+    static const table avx512{&details::merge_registers_avx512, &details::sum_registers_avx512,
+                              &details::add_hashes32_avx512, &details::add_hashes64_avx512};
+    switch (value)
+    {
+        case dispatch::level::sse42:
+            return sse42;
+        case dispatch::level::avx2:
+            return avx2;
+        case dispatch::level::avx512:
+            return avx512;
+        default:
+            break;
+    }
+#else
+    (void) value;
+#endif
+    return scalar;
+}
+
+/**
+ * Get the kernels of the active dispatch level
+ * @return the kernels
+ */
+inline const table& active() noexcept
+{
+    return get(dispatch::active());
+}
+
+/**
+ * Add the hashes by the kernel of the active level
+ * @return false if the level has no kernel for them
+ */
+inline bool add_hashes(int8_t* registers, const uint32_t* hashes, std::size_t count, unsigned k) noexcept
+{
+    const auto kernel = active().add32;
+    if (kernel == nullptr)
+        return false;
+    kernel(registers, hashes, count, k);
+    return true;
+}
+
+inline bool add_hashes(int8_t* registers, const uint64_t* hashes, std::size_t count, unsigned k) noexcept
+{
+    const auto kernel = active().add64;
+    if (kernel == nullptr)
+        return false;
+    kernel(registers, hashes, count, k);
+    return true;
+}
+
+} // namespace kernels
+} // namespace hll
+
+#endif //HLL_KERNELS_HXX
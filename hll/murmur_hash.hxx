@@ -1,6 +1,6 @@
 /**
  * @file hll/murmur_hash.hxx
- * @brief MurmurHash3 C++ implementation
+ * @brief MurmurHash3 and MurmurHash64A C++ implementations
  * @author Daniil Dudkin (unterumarmung)
  */
 
@@ -11,14 +11,18 @@
 #include "details.hxx"
 
 /**
- * MurmurHash3 C++ implementation
- * @param key data pointer
+ * MurmurHash3 C++ implementation over the bytes of a character array, usable in constant expressions.
+ * The chunks are read as little-endian
+ * @tparam Byte char, signed char or unsigned char
+ * @param data data pointer
  * @param length data length
  * @param seed
  * @return hash
  */
-HLL_CONSTEXPR_OR_INLINE uint32_t murmur_hash(const void* key, uint32_t length, uint32_t seed) noexcept
+template<typename Byte>
+HLL_CONSTEXPR_OR_INLINE uint32_t murmur_hash_bytes(const Byte* data, uint32_t length, uint32_t seed) noexcept
 {
+    static_assert(sizeof(Byte) == 1, "Byte must be a character type");
     constexpr uint32_t c1 = 0xcc9e2d51;
     constexpr uint32_t c2 = 0x1b873593;
     constexpr uint32_t r1 = 15;
@@ -26,18 +30,19 @@ HLL_CONSTEXPR_OR_INLINE uint32_t murmur_hash(const void* key, uint32_t length, u
     constexpr uint32_t m = 5;
     constexpr uint32_t n = 0xe6546b64;
     const auto chunk_length = length / 4u;
-    const auto chunks = static_cast<const uint32_t*>(key); // 32 bit extract from `key'
-    const auto tail = static_cast<const uint8_t*>(key) + chunk_length * 4; // tail - last 8 bytes
-    uint32_t h = 0;
+    const auto tail = data + chunk_length * 4; // tail - last 8 bytes
+    uint32_t h = seed;
     uint32_t k = 0;
 
-    h = seed;
-
     // for each 4 byte chunk of `key'
     for (auto i = 0u; i < chunk_length; ++i)
     {
-        // next 4 byte chunk of `key'
-        k = chunks[i];
+        // next 4 byte chunk of `key', compilers merge the byte loads into one
+        const auto chunk = data + i * 4;
+        k = static_cast<uint32_t>(static_cast<uint8_t>(chunk[0]))
+            | static_cast<uint32_t>(static_cast<uint8_t>(chunk[1])) << 8u
+            | static_cast<uint32_t>(static_cast<uint8_t>(chunk[2])) << 16u
+            | static_cast<uint32_t>(static_cast<uint8_t>(chunk[3])) << 24u;
 
         // encode next 4 byte chunk of `key'
         k *= c1;
@@ -56,12 +61,12 @@ HLL_CONSTEXPR_OR_INLINE uint32_t murmur_hash(const void* key, uint32_t length, u
     switch (length & 3u)
     { // `length % 4'
         case 3:
-            k ^= (tail[2] << 16u);
+            k ^= static_cast<uint32_t>(static_cast<uint8_t>(tail[2])) << 16u;
         case 2:
-            k ^= (tail[1] << 8u);
+            k ^= static_cast<uint32_t>(static_cast<uint8_t>(tail[1])) << 8u;
 
         case 1:
-            k ^= tail[0];
+            k ^= static_cast<uint8_t>(tail[0]);
             k *= c1;
             k = (k << r1) | (k >> (32 - r1));
             k *= c2;
@@ -79,4 +84,95 @@ HLL_CONSTEXPR_OR_INLINE uint32_t murmur_hash(const void* key, uint32_t length, u
     return h;
 }
 
+/**
+ * MurmurHash3 C++ implementation
+ * @param key data pointer
+ * @param length data length
+ * @param seed
+ * @return hash
+ */
+inline uint32_t murmur_hash(const void* key, uint32_t length, uint32_t seed) noexcept
+{
+    return murmur_hash_bytes(static_cast<const uint8_t*>(key), length, seed);
+}
+
+/**
+ * MurmurHash64A C++ implementation over the bytes of a character array, usable in constant expressions,
+ * byte-compatible with the one used by Redis
+ * @tparam Byte char, signed char or unsigned char
+ * @param data data pointer
+ * @param length data length
+ * @param seed
+ * @return hash
+ */
+template<typename Byte>
+HLL_CONSTEXPR_OR_INLINE uint64_t murmur_hash64a_bytes(const Byte* data, uint64_t length, uint64_t seed) noexcept
+{
+    static_assert(sizeof(Byte) == 1, "Byte must be a character type");
+    constexpr uint64_t m = 0xc6a4a7935bd1e995;
+    constexpr uint32_t r = 47;
+    const auto chunk_length = length / 8u;
+    const auto tail = data + chunk_length * 8;
+    uint64_t h = seed ^ (length * m);
+
+    // for each 8 byte chunk of `key', read as little-endian
+    for (uint64_t i = 0; i < chunk_length; ++i)
+    {
+        const auto chunk = data + i * 8;
+        uint64_t k = static_cast<uint64_t>(static_cast<uint8_t>(chunk[0]))
+                     | static_cast<uint64_t>(static_cast<uint8_t>(chunk[1])) << 8u
+                     | static_cast<uint64_t>(static_cast<uint8_t>(chunk[2])) << 16u
+                     | static_cast<uint64_t>(static_cast<uint8_t>(chunk[3])) << 24u
+                     | static_cast<uint64_t>(static_cast<uint8_t>(chunk[4])) << 32u
+                     | static_cast<uint64_t>(static_cast<uint8_t>(chunk[5])) << 40u
+                     | static_cast<uint64_t>(static_cast<uint8_t>(chunk[6])) << 48u
+                     | static_cast<uint64_t>(static_cast<uint8_t>(chunk[7])) << 56u;
+
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+
+        h ^= k;
+        h *= m;
+    }
+
+    // remainder
+    switch (length & 7u)
+    { // `length % 8'
+        case 7:
+            h ^= static_cast<uint64_t>(static_cast<uint8_t>(tail[6])) << 48u;
+        case 6:
+            h ^= static_cast<uint64_t>(static_cast<uint8_t>(tail[5])) << 40u;
+        case 5:
+            h ^= static_cast<uint64_t>(static_cast<uint8_t>(tail[4])) << 32u;
+        case 4:
+            h ^= static_cast<uint64_t>(static_cast<uint8_t>(tail[3])) << 24u;
+        case 3:
+            h ^= static_cast<uint64_t>(static_cast<uint8_t>(tail[2])) << 16u;
+        case 2:
+            h ^= static_cast<uint64_t>(static_cast<uint8_t>(tail[1])) << 8u;
+        case 1:
+            h ^= static_cast<uint64_t>(static_cast<uint8_t>(tail[0]));
+            h *= m;
+    }
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+
+    return h;
+}
+
+/**
+ * MurmurHash64A C++ implementation, byte-compatible with the one used by Redis
+ * @param key data pointer
+ * @param length data length
+ * @param seed
+ * @return hash
+ */
+inline uint64_t murmur_hash64a(const void* key, uint64_t length, uint64_t seed) noexcept
+{
+    return murmur_hash64a_bytes(static_cast<const uint8_t*>(key), length, seed);
+}
+
 #endif // HLL_MURMUR_HASH_HXX
@@ -0,0 +1,313 @@
+/**
+ * @file hll/murmur_hash_batch.hxx
+ * @brief MurmurHash3 of many byte strings at once, eight of them in the lanes of AVX2 registers
+ * @author Daniil Dudkin (unterumarmung)
+ */
+#ifndef HLL_MURMUR_HASH_BATCH_HXX
+#define HLL_MURMUR_HASH_BATCH_HXX
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring> // std::memcpy
+
+#include "dispatch.hxx"
+#include "details.hxx" // HLL_X86_64, HLL_TARGET
+#include "murmur_hash.hxx"
+
+#if HLL_X86_64
+#include <immintrin.h>
+#endif
+
+namespace hll
+{
+namespace details
+{
+
+#if HLL_X86_64
+
+constexpr std::size_t murmur_lanes = 8;
+
+HLL_TARGET("avx2")
+inline __m256i murmur_rotl(__m256i value, int shift) noexcept
+{
+    return _mm256_or_si256(_mm256_slli_epi32(value, shift), _mm256_srli_epi32(value, 32 - shift));
+}
+
+HLL_TARGET("avx2")
+inline __m256i murmur_mix_chunk(__m256i chunk) noexcept
+{
+    chunk = _mm256_mullo_epi32(chunk, _mm256_set1_epi32(static_cast<int>(0xcc9e2d51)));
+    chunk = murmur_rotl(chunk, 15);
+    return _mm256_mullo_epi32(chunk, _mm256_set1_epi32(0x1b873593));
+}
+
+HLL_TARGET("avx2")
+inline __m256i murmur_step(__m256i h, __m256i chunk) noexcept
+{
+    h = murmur_rotl(_mm256_xor_si256(h, murmur_mix_chunk(chunk)), 13);
+    return _mm256_add_epi32(_mm256_add_epi32(_mm256_slli_epi32(h, 2), h),
+                            _mm256_set1_epi32(static_cast<int>(0xe6546b64)));
+}
+
+/// 8x8 transpose of 32-bit elements: the rows of the keys become the columns of the chunks
+HLL_TARGET("avx2")
+inline void murmur_transpose(__m256i* rows) noexcept
+{
+    const auto t0 = _mm256_unpacklo_epi32(rows[0], rows[1]);
+    const auto t1 = _mm256_unpackhi_epi32(rows[0], rows[1]);
+    const auto t2 = _mm256_unpacklo_epi32(rows[2], rows[3]);
+    const auto t3 = _mm256_unpackhi_epi32(rows[2], rows[3]);
+    const auto t4 = _mm256_unpacklo_epi32(rows[4], rows[5]);
+    const auto t5 = _mm256_unpackhi_epi32(rows[4], rows[5]);
+    const auto t6 = _mm256_unpacklo_epi32(rows[6], rows[7]);
+    const auto t7 = _mm256_unpackhi_epi32(rows[6], rows[7]);
+    const auto u0 = _mm256_unpacklo_epi64(t0, t2);
+    const auto u1 = _mm256_unpackhi_epi64(t0, t2);
+    const auto u2 = _mm256_unpacklo_epi64(t1, t3);
+    const auto u3 = _mm256_unpackhi_epi64(t1, t3);
+    const auto u4 = _mm256_unpacklo_epi64(t4, t6);
+    const auto u5 = _mm256_unpackhi_epi64(t4, t6);
+    const auto u6 = _mm256_unpacklo_epi64(t5, t7);
+    const auto u7 = _mm256_unpackhi_epi64(t5, t7);
+    rows[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+    rows[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+    rows[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+    rows[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+    rows[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+    rows[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+    rows[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+    rows[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+}
+
+/**
+ * murmur_hash of eight keys, lane by lane. Up to eight chunks of every key are loaded at once and transposed,
+ * the loads are masked by the key lengths and a lane stops changing when its key is out of chunks,
+ * so the cost is set by the longest key of the eight
+ * @param keys data pointers
+ * @param lengths data lengths
+ * @param seed
+ * @param hashes the results
+ */
+HLL_TARGET("avx2")
+inline void murmur_hash_x8(const void* const* keys, const std::size_t* lengths, uint32_t seed, uint32_t* hashes)
+noexcept
+{
+    const uint8_t* data[murmur_lanes];
+    uint32_t sizes[murmur_lanes];
+    for (std::size_t lane = 0; lane < murmur_lanes; ++lane)
+    {
+        data[lane] = static_cast<const uint8_t*>(keys[lane]);
+        sizes[lane] = static_cast<uint32_t>(lengths[lane]);
+    }
+    const auto length = _mm256_setr_epi32(
+            static_cast<int>(sizes[0]), static_cast<int>(sizes[1]), static_cast<int>(sizes[2]),
+            static_cast<int>(sizes[3]), static_cast<int>(sizes[4]), static_cast<int>(sizes[5]),
+            static_cast<int>(sizes[6]), static_cast<int>(sizes[7]));
+    const auto chunks = _mm256_srli_epi32(length, 2);
+    const auto iota = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    uint32_t min_chunks = sizes[0] / 4;
+    uint32_t max_chunks = 0;
+    for (std::size_t lane = 0; lane < murmur_lanes; ++lane)
+    {
+        min_chunks = min_chunks > sizes[lane] / 4 ? sizes[lane] / 4 : min_chunks;
+        max_chunks = max_chunks < sizes[lane] / 4 ? sizes[lane] / 4 : max_chunks;
+    }
+
+    auto h = _mm256_set1_epi32(static_cast<int>(seed));
+    for (uint32_t i = 0; i < max_chunks; i += murmur_lanes)
+    {
+        __m256i rows[murmur_lanes];
+        if (i + murmur_lanes <= min_chunks)
+        {
+            for (std::size_t lane = 0; lane < murmur_lanes; ++lane)
+            {
+                rows[lane] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data[lane] + i * 4));
+            }
+            murmur_transpose(rows);
+            for (std::size_t j = 0; j < murmur_lanes; ++j)
+            {
+                h = murmur_step(h, rows[j]);
+            }
+            continue;
+        }
+
+        // masked off elements are not read, so the loads never run past the keys
+        for (std::size_t lane = 0; lane < murmur_lanes; ++lane)
+        {
+            const auto left = static_cast<int>(sizes[lane] / 4) - static_cast<int>(i);
+            rows[lane] = _mm256_maskload_epi32(reinterpret_cast<const int*>(data[lane] + i * 4),
+                                               _mm256_cmpgt_epi32(_mm256_set1_epi32(left), iota));
+        }
+        murmur_transpose(rows);
+        const auto steps = max_chunks - i < murmur_lanes ? max_chunks - i : murmur_lanes;
+        for (std::size_t j = 0; j < steps; ++j)
+        {
+            const auto active = _mm256_cmpgt_epi32(chunks, _mm256_set1_epi32(static_cast<int>(i + j)));
+            h = _mm256_blendv_epi8(h, murmur_step(h, rows[j]), active);
+        }
+    }
+
+    // the remainders are few bytes per lane, read them one by one not to touch memory past the keys
+    alignas(32) uint32_t tails[murmur_lanes];
+    for (std::size_t lane = 0; lane < murmur_lanes; ++lane)
+    {
+        const auto tail = data[lane] + (sizes[lane] & ~3u);
+        uint32_t value = 0;
+        switch (sizes[lane] & 3u)
+        {
+            case 3:
+                value ^= static_cast<uint32_t>(tail[2]) << 16u;
+            case 2:
+                value ^= static_cast<uint32_t>(tail[1]) << 8u;
+            case 1:
+                value ^= tail[0];
+        }
+        tails[lane] = value;
+    }
+    // a zero tail mixes into zero, so the lanes without a remainder stay intact
+    h = _mm256_xor_si256(h, murmur_mix_chunk(_mm256_load_si256(reinterpret_cast<const __m256i*>(tails))));
+
+    h = _mm256_xor_si256(h, length);
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+    h = _mm256_mullo_epi32(h, _mm256_set1_epi32(static_cast<int>(0x85ebca6b)));
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 13));
+    h = _mm256_mullo_epi32(h, _mm256_set1_epi32(static_cast<int>(0xc2b2ae35)));
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(hashes), h);
+}
+
+/**
+ * Hashes the keys eight at a time. The keys of a block are regrouped by length first if their lengths differ much,
+ * so the lanes of a group finish at about the same time
+ */
+inline void murmur_hash_batch_avx2(const void* const* keys, const std::size_t* lengths, std::size_t count,
+                                   uint32_t seed, uint32_t* hashes) noexcept
+{
+    constexpr std::size_t block_size = 64;
+    // 16-byte length classes, the last one takes all the longer keys
+    constexpr std::size_t class_bytes = 16;
+    constexpr std::size_t classes = 16;
+    // shorter keys are hashed as fast by the scalar code: a lane step is bound by the latency of vpmulld
+    constexpr std::size_t min_simd_length = 32;
+    static const uint8_t padding = 0;
+
+    for (std::size_t offset = 0; offset < count; offset += block_size)
+    {
+        const auto size = count - offset < block_size ? count - offset : block_size;
+        const auto block_keys = keys + offset;
+        const auto block_lengths = lengths + offset;
+        const auto block_hashes = hashes + offset;
+
+        auto min_length = block_lengths[0];
+        auto max_length = block_lengths[0];
+        for (std::size_t i = 1; i < size; ++i)
+        {
+            min_length = min_length > block_lengths[i] ? block_lengths[i] : min_length;
+            max_length = max_length < block_lengths[i] ? block_lengths[i] : max_length;
+        }
+        if (max_length < min_simd_length)
+        {
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                block_hashes[i] = murmur_hash(block_keys[i], static_cast<uint32_t>(block_lengths[i]), seed);
+            }
+            continue;
+        }
+
+        uint8_t order[block_size];
+        const auto regroup = max_length - min_length >= class_bytes;
+        if (regroup)
+        {
+            // counting sort of the key indices by length class
+            std::size_t starts[classes + 1] = {};
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                const auto length_class = block_lengths[i] / class_bytes;
+                ++starts[(length_class < classes - 1 ? length_class : classes - 1) + 1];
+            }
+            for (std::size_t c = 1; c <= classes; ++c)
+            {
+                starts[c] += starts[c - 1];
+            }
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                const auto length_class = block_lengths[i] / class_bytes;
+                order[starts[length_class < classes - 1 ? length_class : classes - 1]++] = static_cast<uint8_t>(i);
+            }
+        }
+
+        for (std::size_t group = 0; group < size; group += murmur_lanes)
+        {
+            const auto lanes = size - group < murmur_lanes ? size - group : murmur_lanes;
+            std::size_t group_length = 0;
+            for (std::size_t lane = 0; lane < lanes; ++lane)
+            {
+                const auto length = block_lengths[regroup ? order[group + lane] : group + lane];
+                group_length = group_length < length ? length : group_length;
+            }
+            if (group_length < min_simd_length)
+            {
+                for (std::size_t lane = 0; lane < lanes; ++lane)
+                {
+                    const auto index = regroup ? order[group + lane] : group + lane;
+                    block_hashes[index] = murmur_hash(block_keys[index], static_cast<uint32_t>(block_lengths[index]),
+                                                      seed);
+                }
+                continue;
+            }
+            if (!regroup && lanes == murmur_lanes)
+            {
+                murmur_hash_x8(block_keys + group, block_lengths + group, seed, block_hashes + group);
+                continue;
+            }
+
+            const void* lane_keys[murmur_lanes];
+            std::size_t lane_lengths[murmur_lanes];
+            uint32_t lane_hashes[murmur_lanes];
+            for (std::size_t lane = 0; lane < murmur_lanes; ++lane)
+            {
+                // the spare lanes of the last group hash an empty key, they read nothing
+                const auto index = regroup ? order[group + (lane < lanes ? lane : 0)] : group + lane;
+                lane_keys[lane] = lane < lanes ? block_keys[index] : &padding;
+                lane_lengths[lane] = lane < lanes ? block_lengths[index] : 0;
+            }
+            murmur_hash_x8(lane_keys, lane_lengths, seed, lane_hashes);
+            for (std::size_t lane = 0; lane < lanes; ++lane)
+            {
+                block_hashes[regroup ? order[group + lane] : group + lane] = lane_hashes[lane];
+            }
+        }
+    }
+}
+
+#endif // HLL_X86_64
+
+} // namespace details
+} // namespace hll
+
+/**
+ * MurmurHash3 of many keys, the same values as murmur_hash of every key gives.
+ * Uses AVX2 at the AVX2 dispatch level and above
+ * @param keys data pointers
+ * @param lengths data lengths
+ * @param count number of the keys
+ * @param seed
+ * @param hashes the results, in the order of the keys
+ */
+inline void murmur_hash_batch(const void* const* keys, const std::size_t* lengths, std::size_t count,
+                              uint32_t seed, uint32_t* hashes) noexcept
+{
+#if HLL_X86_64
+    if (hll::dispatch::active() >= hll::dispatch::level::avx2 && count >= hll::details::murmur_lanes)
+    {
+        hll::details::murmur_hash_batch_avx2(keys, lengths, count, seed, hashes);
+        return;
+    }
+#endif
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        hashes[i] = murmur_hash(keys[i], static_cast<uint32_t>(lengths[i]), seed);
+    }
+}
+
+#endif //HLL_MURMUR_HASH_BATCH_HXX
@@ -0,0 +1,246 @@
+/**
+ * @file hll/redis.hxx
+ * @brief Import and export of sketches in the Redis HyperLogLog string format
+ * @author Daniil Dudkin (unterumarmung)
+ */
+#ifndef HLL_REDIS_HXX
+#define HLL_REDIS_HXX
+
+#include <cstdint>
+#include <cstring> // std::memcmp
+#include <vector>
+#include "hyper_log_log.hxx"
+
+namespace hll
+{
+namespace redis
+{
+
+/// precision of Redis' HyperLogLog
+constexpr std::size_t precision = 14;
+
+/**
+ * A sketch compatible with Redis' HyperLogLog: 2^14 registers and the same 64-bit hash,
+ * so values added here and by PFADD land into the same registers
+ * @tparam T the type of values
+ */
+template<typename T>
+using sketch = hyper_log_log<T, precision, hll::murmur64a_hash>;
+
+/// encodings of the Redis HyperLogLog string
+enum class encoding : uint8_t
+{
+    dense = 0,
+    sparse = 1
+};
+
+namespace details
+{
+
+constexpr std::size_t registers_count = 1u << precision;
+constexpr std::size_t header_size = 16;
+constexpr std::size_t register_bits = 6;
+constexpr uint8_t register_max = (1u << register_bits) - 1;
+constexpr std::size_t dense_size = header_size + (registers_count * register_bits + 7) / 8;
+/// Redis' default of hll-sparse-max-bytes
+constexpr std::size_t sparse_max_bytes = 3000;
+
+constexpr uint8_t sparse_xzero_bit = 0x40;
+constexpr uint8_t sparse_val_bit = 0x80;
+constexpr uint32_t sparse_val_max_value = 32;
+constexpr uint32_t sparse_val_max_len = 4;
+constexpr uint32_t sparse_zero_max_len = 64;
+constexpr uint32_t sparse_xzero_max_len = 16384;
+
+inline uint8_t get_dense_register(const uint8_t* registers, std::size_t index) noexcept
+{
+    const auto byte = index * register_bits / 8;
+    const auto first_bit = index * register_bits & 7u;
+    unsigned value = registers[byte] >> first_bit;
+    // the last register ends exactly at the end of the buffer
+    if (first_bit > 8 - register_bits)
+        value |= static_cast<unsigned>(registers[byte + 1]) << (8 - first_bit);
+    return static_cast<uint8_t>(value & register_max);
+}
+
+inline void set_dense_register(uint8_t* registers, std::size_t index, uint8_t value) noexcept
+{
+    const auto byte = index * register_bits / 8;
+    const auto first_bit = index * register_bits & 7u;
+    registers[byte] = static_cast<uint8_t>(registers[byte] | (value << first_bit));
+    if (first_bit > 8 - register_bits)
+        registers[byte + 1] = static_cast<uint8_t>(registers[byte + 1] | (value >> (8 - first_bit)));
+}
+
+inline void write_header(std::vector<uint8_t>& out, encoding enc)
+{
+    const uint8_t header[header_size] = {'H', 'Y', 'L', 'L', static_cast<uint8_t>(enc), 0, 0, 0,
+            // cached cardinality is marked as invalid, Redis recomputes it on the next PFCOUNT
+                                         0, 0, 0, 0, 0, 0, 0, 0x80};
+    out.insert(out.end(), header, header + header_size);
+}
+
+inline void append_zeros(std::vector<uint8_t>& out, uint32_t length)
+{
+    while (length > 0)
+    {
+        if (length > sparse_zero_max_len)
+        {
+            const auto run = std::min(length, sparse_xzero_max_len);
+            out.push_back(static_cast<uint8_t>(sparse_xzero_bit | ((run - 1) >> 8u)));
+            out.push_back(static_cast<uint8_t>((run - 1) & 0xffu));
+            length -= run;
+        } else
+        {
+            out.push_back(static_cast<uint8_t>(length - 1));
+            length = 0;
+        }
+    }
+}
+
+inline void append_value(std::vector<uint8_t>& out, uint32_t value, uint32_t length)
+{
+    while (length > 0)
+    {
+        const auto run = std::min(length, sparse_val_max_len);
+        out.push_back(static_cast<uint8_t>(sparse_val_bit | ((value - 1) << 2u) | (run - 1)));
+        length -= run;
+    }
+}
+
+/**
+ * Encodes registers with the sparse opcodes
+ * @return false if some register does not fit into a VAL opcode or the result exceeds max_bytes
+ */
+template<typename Registers>
+bool encode_sparse(const Registers& registers, std::vector<uint8_t>& out, std::size_t max_bytes)
+{
+    write_header(out, encoding::sparse);
+    std::size_t i = 0;
+    while (i < registers_count)
+    {
+        const auto value = static_cast<uint32_t>(registers[i]);
+        if (value > sparse_val_max_value)
+            return false;
+
+        std::size_t j = i + 1;
+        while (j < registers_count && static_cast<uint32_t>(registers[j]) == value)
+            ++j;
+
+        if (value == 0)
+            append_zeros(out, static_cast<uint32_t>(j - i));
+        else
+            append_value(out, value, static_cast<uint32_t>(j - i));
+
+        if (out.size() > max_bytes)
+            return false;
+        i = j;
+    }
+    return true;
+}
+
+template<typename Registers>
+void encode_dense(const Registers& registers, std::vector<uint8_t>& out)
+{
+    write_header(out, encoding::dense);
+    out.resize(dense_size, 0);
+    for (std::size_t i = 0; i < registers_count; ++i)
+    {
+        set_dense_register(out.data() + header_size, i, static_cast<uint8_t>(registers[i]));
+    }
+}
+
+template<typename Registers>
+bool decode_sparse(const uint8_t* data, std::size_t size, Registers& registers) noexcept
+{
+    std::size_t index = 0;
+    const auto end = data + size;
+    while (data < end)
+    {
+        uint32_t length = 0;
+        uint32_t value = 0;
+        if ((*data & 0xc0u) == 0)
+        { // ZERO: 00xxxxxx
+            length = (*data & 0x3fu) + 1;
+            data += 1;
+        } else if ((*data & 0xc0u) == sparse_xzero_bit)
+        { // XZERO: 01xxxxxx yyyyyyyy
+            if (data + 1 == end)
+                return false;
+            length = (((*data & 0x3fu) << 8u) | data[1]) + 1;
+            data += 2;
+        } else
+        { // VAL: 1vvvvvxx
+            value = ((*data >> 2u) & 0x1fu) + 1;
+            length = (*data & 0x3u) + 1;
+            data += 1;
+        }
+
+        if (index + length > registers_count)
+            return false;
+        for (std::size_t i = index; i < index + length; ++i)
+        {
+            registers[i] = static_cast<typename Registers::value_type>(value);
+        }
+        index += length;
+    }
+    return index == registers_count;
+}
+
+} // namespace details
+
+/**
+ * Exports a sketch into the Redis HyperLogLog string format.
+ * Like Redis itself, uses the sparse encoding while it is representable and not larger than sparse_max_bytes
+ * @param source the sketch
+ * @param sparse_max_bytes the limit of the sparse representation size, hll-sparse-max-bytes in Redis' config
+ * @return the string, can be stored with SET or RESTORE-d from a dump
+ */
+template<typename T>
+std::vector<uint8_t> encode(const sketch<T>& source, std::size_t sparse_max_bytes = details::sparse_max_bytes)
+{
+    std::vector<uint8_t> result;
+    if (details::encode_sparse(source.registers(), result, sparse_max_bytes))
+        return result;
+
+    result.clear();
+    details::encode_dense(source.registers(), result);
+    return result;
+}
+
+/**
+ * Imports a sketch from the Redis HyperLogLog string format, replacing its registers
+ * @param data the string
+ * @param size the string length
+ * @param target the sketch to load into
+ * @return false if the string is not a valid HyperLogLog, the sketch is left unspecified then
+ */
+template<typename T>
+bool decode(const void* data, std::size_t size, sketch<T>& target) noexcept
+{
+    const auto bytes = static_cast<const uint8_t*>(data);
+    if (size < details::header_size || std::memcmp(bytes, "HYLL", 4) != 0)
+        return false;
+
+    auto& registers = target.registers();
+    switch (static_cast<encoding>(bytes[4]))
+    {
+        case encoding::dense:
+            if (size != details::dense_size)
+                return false;
+            for (std::size_t i = 0; i < details::registers_count; ++i)
+            {
+                registers[i] = static_cast<typename sketch<T>::register_type>(
+                        details::get_dense_register(bytes + details::header_size, i));
+            }
+            return true;
+        case encoding::sparse:
+            return details::decode_sparse(bytes + details::header_size, size - details::header_size, registers);
+    }
+    return false;
+}
+
+} // namespace redis
+} // namespace hll
+
+#endif //HLL_REDIS_HXX
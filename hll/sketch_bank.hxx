@@ -0,0 +1,301 @@
+/**
+ * @file hll/sketch_bank.hxx
+ * @brief Many sketches of the same precision in one arena, addressed by stable handles
+ * @author Daniil Dudkin (unterumarmung)
+ */
+#ifndef HLL_SKETCH_BANK_HXX
+#define HLL_SKETCH_BANK_HXX
+
+#include <algorithm> // std::max, std::copy, std::fill
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <utility> // std::move
+#include <vector>
+#include "hyper_log_log.hxx"
+
+namespace hll
+{
+
+/**
+ * @brief Many sketches of the same precision, e.g. one per customer, stored back to back in blocks of registers
+ * instead of as separate objects. A sketch is addressed by a handle that stays valid until it is released,
+ * released handles are reused by the next created sketches. The sketches count and merge by the same kernels
+ * and produce the same estimates as hyper_log_log<T, k, Hash>.
+ * The registers and add functions take contained handles only, as the checked ones would cost a lookup per value,
+ * count, merge, sketch and release check the handles and do nothing for the others
+ * @tparam T the type of values
+ * @tparam k number that controls number of registers of every sketch as 2^k
+ * @tparam Hash hash policy, as in hyper_log_log
+ */
+template<typename T, std::size_t k, typename Hash = hll::murmur3_hash>
+class sketch_bank
+{
+public:
+    /// type of registers of the data structure
+    using register_type = int8_t;
+    /// type of size values
+    using size_type = size_t;
+    using value_type = T;
+    using hasher = Hash;
+    using hash_result_type = typename Hash::result_type;
+    /// a sketch the bank stores, to take out or merge in
+    using sketch_type = hyper_log_log<T, k, Hash>;
+    /// identifier of a sketch in the bank
+    using handle_type = uint32_t;
+    static constexpr size_type registers_count = sketch_type::registers_count;
+    /// number of bits of the hash values
+    static constexpr size_type hash_bits = sketch_type::hash_bits;
+    /// number of sketches allocated at once, a power of two with 256 KiB of registers
+    static constexpr size_type block_sketches = registers_count >= (1u << 18u) ? 1 : (1u << 18u) / registers_count;
+
+private:
+    std::vector<std::unique_ptr<register_type[]>> m_blocks;
+    std::vector<bool> m_live;
+    std::vector<handle_type> m_free;
+public:
+    /**
+     * Create an empty sketch, reusing a released handle if there is one
+     * @return the handle of the sketch
+     */
+    handle_type create();
+
+    /**
+     * Release the sketch, its handle is invalid until it is returned by create again.
+     * Releasing a handle that is not contained, e.g. released twice, does nothing
+     * @param handle the sketch
+     * @return true if the sketch was released, false if the handle is not contained
+     */
+    bool release(handle_type handle);
+
+    /**
+     * Check does the handle refer to a sketch in the bank
+     * @param handle the handle
+     * @return true if the handle is created and not released
+     */
+    bool contains(handle_type handle) const noexcept
+    {
+        return handle < m_live.size() && m_live[handle];
+    }
+
+    /**
+     * Get number of the sketches in the bank
+     * @return the number
+     */
+    size_type size() const noexcept
+    {
+        return m_live.size() - m_free.size();
+    }
+
+    /**
+     * Get number of the handles ever created, released ones included: handles are below this number
+     * @return the number
+     */
+    size_type slots() const noexcept
+    {
+        return m_live.size();
+    }
+
+    /**
+     * Remove all the sketches and free the memory
+     */
+    void clear() noexcept
+    {
+        m_blocks.clear();
+        m_live.clear();
+        m_free.clear();
+    }
+
+    /**
+     * Get the registers of the sketch
+     * @param handle the sketch, must be contained
+     * @return registers_count registers
+     */
+    const register_type* registers(handle_type handle) const noexcept
+    {
+        assert(contains(handle));
+        return m_blocks[handle / block_sketches].get() + (handle % block_sketches) * registers_count;
+    }
+
+    /**
+     * Get the registers of the sketch, e.g. to load them from a serialized form
+     * @param handle the sketch, must be contained
+     * @return registers_count registers
+     */
+    register_type* registers(handle_type handle) noexcept
+    {
+        assert(contains(handle));
+        return m_blocks[handle / block_sketches].get() + (handle % block_sketches) * registers_count;
+    }
+
+    /**
+     * Add an element to the sketch
+     * @param handle the sketch, must be contained
+     * @param value the element
+     */
+    void add(handle_type handle, const value_type& value)
+    {
+        add_hash(handle, Hash{}(value));
+    }
+
+    /**
+     * Add elements, each to its own sketch, hashing them in blocks before updating the registers
+     * @param handles the sketches, must be contained
+     * @param values the elements, values[i] is added to the sketch handles[i]
+     * @param count number of the elements
+     */
+    void add(const handle_type* handles, const value_type* values, size_type count);
+
+    /**
+     * Add an element to the sketch by its hash
+     * @param handle the sketch, must be contained
+     * @param hash_value the hash of the element
+     */
+    void add_hash(handle_type handle, hash_result_type hash_value) noexcept
+    {
+        auto& target = registers(handle)[hll::details::register_index(hash_value, k)];
+        const auto rank = hll::details::register_rank(hash_value, k);
+        target = static_cast<register_type>(std::max(static_cast<uint32_t>(target), rank));
+    }
+
+    /**
+     * Add elements by their hashes, each to its own sketch
+     * @param handles the sketches, must be contained
+     * @param hashes the hashes of the elements, hashes[i] is added to the sketch handles[i]
+     * @param count number of the hashes
+     */
+    void add_hashes(const handle_type* handles, const hash_result_type* hashes, size_type count) noexcept;
+
+    /**
+     * Get unique numbers count of the sketch
+     * @param handle the sketch
+     * @return the count, 0 if the handle is not contained
+     */
+    size_type count(handle_type handle) const
+    {
+        if (!contains(handle))
+            return 0;
+        const auto sums = hll::kernels::active().sum(registers(handle), registers_count);
+        return hll::details::estimate_cardinality(sums, registers_count, hash_bits);
+    }
+
+    /**
+     * Get unique numbers counts of all the sketches
+     * @return the counts indexed by handle, zeros for the released handles
+     */
+    std::vector<size_type> count_all() const;
+
+    /**
+     * Merge a sketch into the sketch of the bank
+     * @param handle the sketch of the bank
+     * @param rhs the sketch to merge
+     * @return false if the handle is not contained, nothing is merged then
+     */
+    bool merge(handle_type handle, const sketch_type& rhs) noexcept
+    {
+        if (!contains(handle))
+            return false;
+        hll::kernels::active().merge(registers(handle), rhs.registers().data(), registers_count);
+        return true;
+    }
+
+    /**
+     * Merge one sketch of the bank into another
+     * @param handle the sketch to merge into
+     * @param other the sketch to merge
+     * @return false if either handle is not contained, nothing is merged then
+     */
+    bool merge(handle_type handle, handle_type other) noexcept
+    {
+        if (!contains(handle) || !contains(other))
+            return false;
+        hll::kernels::active().merge(registers(handle), registers(other), registers_count);
+        return true;
+    }
+
+    /**
+     * Copy the sketch out of the bank
+     * @param handle the sketch
+     * @return the copy, an empty sketch if the handle is not contained
+     */
+    sketch_type sketch(handle_type handle) const noexcept
+    {
+        sketch_type result{};
+        if (!contains(handle))
+            return result;
+        std::copy(registers(handle), registers(handle) + registers_count, result.registers().begin());
+        return result;
+    }
+};
+
+template<typename T, std::size_t k, typename Hash>
+auto sketch_bank<T, k, Hash>::create() -> handle_type
+{
+    if (!m_free.empty())
+    {
+        const auto handle = m_free.back();
+        m_free.pop_back();
+        m_live[handle] = true;
+        return handle;
+    }
+
+    if (m_live.size() == m_blocks.size() * block_sketches)
+    {
+        std::unique_ptr<register_type[]> block(new register_type[block_sketches * registers_count]());
+        m_blocks.push_back(std::move(block));
+    }
+    m_live.push_back(true);
+    return static_cast<handle_type>(m_live.size() - 1);
+}
+
+template<typename T, std::size_t k, typename Hash>
+bool sketch_bank<T, k, Hash>::release(handle_type handle)
+{
+    if (!contains(handle))
+        return false;
+    std::fill(registers(handle), registers(handle) + registers_count, register_type{});
+    m_free.push_back(handle);
+    m_live[handle] = false;
+    return true;
+}
+
+template<typename T, std::size_t k, typename Hash>
+void sketch_bank<T, k, Hash>::add(const handle_type* handles, const value_type* values, size_type count)
+{
+    size_type offset = 0;
+    hll::details::hash_blocks<Hash, T>(values, values + count, [this, handles, &offset](const hash_result_type* hashes,
+                                                                                        size_type block_count)
+    {
+        add_hashes(handles + offset, hashes, block_count);
+        offset += block_count;
+    });
+}
+
+template<typename T, std::size_t k, typename Hash>
+void sketch_bank<T, k, Hash>::add_hashes(const handle_type* handles, const hash_result_type* hashes, size_type count)
+noexcept
+{
+    for (size_type i = 0; i < count; ++i)
+    {
+        add_hash(handles[i], hashes[i]);
+    }
+}
+
+template<typename T, std::size_t k, typename Hash>
+auto sketch_bank<T, k, Hash>::count_all() const -> std::vector<size_type>
+{
+    const auto& kernels = hll::kernels::active();
+    std::vector<size_type> result(m_live.size());
+    for (size_type handle = 0; handle < m_live.size(); ++handle)
+    {
+        if (!m_live[handle])
+            continue;
+        const auto sums = kernels.sum(registers(static_cast<handle_type>(handle)), registers_count);
+        result[handle] = hll::details::estimate_cardinality(sums, registers_count, hash_bits);
+    }
+    return result;
+}
+
+} // namespace hll
+
+#endif //HLL_SKETCH_BANK_HXX
@@ -0,0 +1,212 @@
+/**
+ * @file hll/slab.hxx
+ * @brief Size-class slab of blocks for the registers of many short-lived sketches
+ * @author Daniil Dudkin (unterumarmung)
+ */
+#ifndef HLL_SLAB_HXX
+#define HLL_SLAB_HXX
+
+#include <array>
+#include <cstdint>
+#include <cstdlib> // std::malloc, std::free
+#include <memory>
+#include <new> // std::bad_alloc
+#include <utility> // std::move
+#include <vector>
+
+namespace hll
+{
+namespace details
+{
+
+struct free_deleter
+{
+    void operator()(void* pointer) const noexcept
+    {
+        std::free(pointer);
+    }
+};
+
+} // namespace details
+
+/**
+ * @brief Blocks of power-of-two sizes carved out of larger chunks, one free list per size, so sketches
+ * created and destroyed by the millions reuse the same memory instead of fragmenting the heap, and a block
+ * is taken and returned in a few instructions while its pages stay mapped. Blocks are not zeroed: the user
+ * initializes them once, as std::vector does with its elements, instead of paying for zeroing on both ends.
+ * Zeroing on return would only move that pass, so a sketch's creation and clear() still zero its registers once,
+ * the slab saves the heap allocation around it.
+ * Memory goes back to the system only when the slab is released or destroyed.
+ * A slab is not thread-safe, use one per thread or guard it by a lock
+ */
+class slab
+{
+public:
+    /// size of the smallest block, requests are rounded up to a power of two not less than it
+    static constexpr std::size_t min_block_size = 16;
+    /// size of a chunk the blocks are carved out of, larger blocks take a chunk each
+    static constexpr std::size_t chunk_size = 1u << 16u;
+
+    slab() = default;
+    slab(const slab&) = delete;
+    slab& operator=(const slab&) = delete;
+
+    /**
+     * Allocate an uninitialized block
+     * @param size size of the block in bytes
+     * @return the block, aligned by the lesser of its size rounded up to a power of two and alignof(max_align_t);
+     * throws std::bad_alloc if the system has no memory
+     */
+    void* allocate(std::size_t size)
+    {
+        const auto index = size_class(size);
+        auto& head = m_free[index];
+        if (head != nullptr)
+        {
+            const auto block = head;
+            head = block->next;
+            return block;
+        }
+
+        const auto block_size = static_cast<std::size_t>(1) << (index + min_block_shift);
+        auto& region = m_regions[index];
+        if (region.next == region.end)
+        {
+            const auto size_of_chunk = block_size > chunk_size ? block_size : chunk_size;
+            std::unique_ptr<unsigned char, details::free_deleter> chunk(
+                    static_cast<unsigned char*>(std::malloc(size_of_chunk)));
+            if (chunk == nullptr)
+                throw std::bad_alloc();
+            m_chunks.push_back(std::move(chunk));
+            m_reserved += size_of_chunk;
+            region.next = m_chunks.back().get();
+            region.end = region.next + size_of_chunk;
+        }
+        const auto block = region.next;
+        region.next += block_size;
+        return block;
+    }
+
+    /**
+     * Return a block for the next allocation of its size
+     * @param block the block given by allocate
+     * @param size the size it was allocated with
+     */
+    void deallocate(void* block, std::size_t size) noexcept
+    {
+        auto& head = m_free[size_class(size)];
+        const auto node = static_cast<free_block*>(block);
+        node->next = head;
+        head = node;
+    }
+
+    /**
+     * Give all the memory back to the system, the blocks given by allocate become invalid
+     */
+    void release() noexcept
+    {
+        m_chunks.clear();
+        m_free.fill(nullptr);
+        m_regions.fill(region{});
+        m_reserved = 0;
+    }
+
+    /**
+     * Get number of bytes the slab took from the system
+     * @return the number
+     */
+    std::size_t reserved() const noexcept
+    {
+        return m_reserved;
+    }
+
+private:
+    static constexpr std::size_t min_block_shift = 4;
+    /// blocks of up to 2^(4 + 59) bytes
+    static constexpr std::size_t size_classes = 60;
+
+    struct free_block
+    {
+        free_block* next;
+    };
+
+    struct region
+    {
+        unsigned char* next = nullptr;
+        unsigned char* end = nullptr;
+    };
+
+    static std::size_t size_class(std::size_t size) noexcept
+    {
+        std::size_t index = 0;
+        while ((static_cast<std::size_t>(min_block_size) << index) < size)
+            ++index;
+        return index;
+    }
+
+    std::vector<std::unique_ptr<unsigned char, details::free_deleter>> m_chunks;
+    std::array<free_block*, size_classes> m_free{};
+    std::array<region, size_classes> m_regions{};
+    std::size_t m_reserved = 0;
+};
+
+/**
+ * @brief Standard allocator taking the memory from a slab, e.g. for dynamic_hyper_log_log's registers.
+ * Copies share the slab, which must outlive the containers using them
+ * @tparam T the type of the allocated objects
+ */
+template<typename T>
+class slab_allocator
+{
+public:
+    using value_type = T;
+
+    explicit slab_allocator(slab& resource) noexcept
+            : m_slab(&resource)
+    {
+    }
+
+    template<typename U>
+    slab_allocator(const slab_allocator<U>& other) noexcept
+            : m_slab(other.resource())
+    {
+    }
+
+    T* allocate(std::size_t count)
+    {
+        return static_cast<T*>(m_slab->allocate(count * sizeof(T)));
+    }
+
+    void deallocate(T* pointer, std::size_t count) noexcept
+    {
+        m_slab->deallocate(pointer, count * sizeof(T));
+    }
+
+    /**
+     * Get the slab
+     * @return the slab the memory is taken from
+     */
+    slab* resource() const noexcept
+    {
+        return m_slab;
+    }
+
+    template<typename U>
+    friend bool operator==(const slab_allocator& lhs, const slab_allocator<U>& rhs) noexcept
+    {
+        return lhs.resource() == rhs.resource();
+    }
+
+    template<typename U>
+    friend bool operator!=(const slab_allocator& lhs, const slab_allocator<U>& rhs) noexcept
+    {
+        return lhs.resource() != rhs.resource();
+    }
+
+private:
+    slab* m_slab;
+};
+
+} // namespace hll
+
+#endif //HLL_SLAB_HXX
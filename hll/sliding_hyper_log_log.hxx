@@ -0,0 +1,281 @@
+/**
+ * @file hll/sliding_hyper_log_log.hxx
+ * @brief Sliding HyperLogLog: unique values count over any recent time window
+ * @author Daniil Dudkin (unterumarmung)
+ */
+#ifndef HLL_SLIDING_HYPER_LOG_LOG_HXX
+#define HLL_SLIDING_HYPER_LOG_LOG_HXX
+
+#include <algorithm> // std::lower_bound, std::upper_bound, std::partition_point, std::max
+#include <cstdint>
+#include <vector>
+#include "hyper_log_log.hxx"
+
+namespace hll
+{
+
+/**
+ * @brief Sliding HyperLogLog (Chabchoub, Hebrail): every register keeps the list of future possible maxima,
+ * the values it had since max_window ago that can still become its maximum when older values leave a window.
+ * A value is dropped from the list once a later or equally recent value has the same or a greater rank, so the list
+ * has increasing timestamps and decreasing ranks, and its first value inside a window is the register's maximum
+ * over that window. A query over any window up to max_window is one pass over the lists, its count equals
+ * hyper_log_log's count of the values added inside the window.
+ * Only the windows ending at the latest added timestamp or later can be queried: the lists have already dropped
+ * the values that the later ones made useless, so the maximum over a past window is lost
+ * @tparam T the type of values
+ * @tparam k number that controls number of registers as 2^k
+ * @tparam Hash hash policy, as in hyper_log_log
+ */
+template<typename T, std::size_t k, typename Hash = hll::murmur3_hash>
+class sliding_hyper_log_log
+{
+public:
+    /// type of registers of the data structure
+    using register_type = int8_t;
+    /// type of size values
+    using size_type = size_t;
+    using value_type = T;
+    using hasher = Hash;
+    using hash_result_type = typename Hash::result_type;
+    using this_type = sliding_hyper_log_log;
+    /// a sketch of the values of a window
+    using sketch_type = hyper_log_log<T, k, Hash>;
+    /// time in any units, e.g. seconds or milliseconds, below 2^56
+    using timestamp_type = uint64_t;
+    static constexpr size_type registers_count = sketch_type::registers_count;
+    /// number of bits of the hash values
+    static constexpr size_type hash_bits = sketch_type::hash_bits;
+
+private:
+    /// a possible maximum as timestamp << rank_bits | rank
+    using entry_type = uint64_t;
+    static constexpr unsigned rank_bits = 8;
+
+    static constexpr timestamp_type timestamp_of(entry_type entry) noexcept
+    {
+        return entry >> rank_bits;
+    }
+
+    static constexpr uint32_t rank_of(entry_type entry) noexcept
+    {
+        return static_cast<uint32_t>(entry & ((1u << rank_bits) - 1));
+    }
+
+    /// is the timestamp not older than window - 1 time units before now
+    static constexpr bool inside(timestamp_type timestamp, timestamp_type window, timestamp_type now) noexcept
+    {
+        return timestamp + window > now;
+    }
+
+    /// can a window ending at now be queried
+    bool queryable(timestamp_type now) const noexcept
+    {
+        return now >= m_latest;
+    }
+
+    static void insert(std::vector<entry_type>& list, timestamp_type timestamp, uint32_t rank);
+
+    timestamp_type m_max_window;
+    /// the latest timestamp added
+    timestamp_type m_latest = 0;
+    std::vector<std::vector<entry_type>> m_lists;
+public:
+    /**
+     * Construct an empty sketch
+     * @param max_window the longest window to query, older values are dropped
+     */
+    explicit sliding_hyper_log_log(timestamp_type max_window)
+            : m_max_window(max_window), m_lists(registers_count)
+    {
+    }
+
+    /**
+     * Get the longest window to query
+     * @return the window
+     */
+    timestamp_type max_window() const noexcept
+    {
+        return m_max_window;
+    }
+
+    /**
+     * Add an element
+     * @param value the element
+     * @param now the time of the element, the elements usually come in the order of time, though may be late
+     */
+    void add(const value_type& value, timestamp_type now)
+    {
+        add_hash(Hash{}(value), now);
+    }
+
+    /**
+     * Add an element by its hash
+     * @param hash_value the hash of the element
+     * @param now the time of the element
+     */
+    void add_hash(hash_result_type hash_value, timestamp_type now);
+
+    /**
+     * Get the latest timestamp added, the earliest end of a window that can be queried
+     * @return the timestamp, 0 for an empty sketch
+     */
+    timestamp_type latest() const noexcept
+    {
+        return m_latest;
+    }
+
+    /**
+     * Get unique numbers count of the elements added inside the window
+     * @param window the window, not longer than max_window
+     * @param now the end of the window, the elements of the timestamps in (now - window; now] are counted
+     * @return the count, 0 if now is earlier than latest()
+     */
+    size_type count(timestamp_type window, timestamp_type now) const;
+
+    /**
+     * Get the sketch of the elements added inside the window, e.g. to merge with the ones of other windows
+     * @param window the window, not longer than max_window
+     * @param now the end of the window
+     * @return the sketch, empty if now is earlier than latest()
+     */
+    sketch_type sketch(timestamp_type window, timestamp_type now) const;
+
+    /**
+     * Drop the elements that are out of the longest window, the lists are also trimmed by add
+     * @param now the current time
+     */
+    void expire(timestamp_type now) noexcept;
+
+    /**
+     * Clear the data structure
+     */
+    void clear() noexcept
+    {
+        for (auto& list : m_lists)
+        {
+            list.clear();
+        }
+        m_latest = 0;
+    }
+
+    /**
+     * Merge the elements of another sliding sketch, e.g. of another stream over the same time
+     * @param rhs the sketch
+     */
+    void merge(const this_type& rhs);
+
+private:
+    template<typename Sink>
+    void window_registers(timestamp_type window, timestamp_type now, Sink sink) const
+    {
+        for (size_type index = 0; index < registers_count; ++index)
+        {
+            const auto& list = m_lists[index];
+            // the timestamps increase, so the values inside the window follow each other and the first is the largest
+            const auto first = std::partition_point(list.begin(), list.end(), [window, now](entry_type entry)
+            {
+                return !inside(timestamp_of(entry), window, now);
+            });
+            if (first != list.end() && timestamp_of(*first) <= now)
+                sink(index, rank_of(*first));
+        }
+    }
+};
+
+template<typename T, std::size_t k, typename Hash>
+void sliding_hyper_log_log<T, k, Hash>::insert(std::vector<entry_type>& list, timestamp_type timestamp, uint32_t rank)
+{
+    const auto key = timestamp << rank_bits;
+    // an entry as recent or later with the same or a greater rank makes the new one useless
+    const auto later = std::lower_bound(list.begin(), list.end(), key);
+    if (later != list.end() && rank_of(*later) >= rank)
+        return;
+
+    // the new entry makes the earlier entries with the same or a lower rank useless,
+    // as the ranks decrease they are the last ones before it
+    const auto end = std::upper_bound(list.begin(), list.end(), key | ((1u << rank_bits) - 1));
+    const auto first = std::partition_point(list.begin(), end, [rank](entry_type entry)
+    {
+        return rank_of(entry) > rank;
+    });
+    if (first == end)
+    {
+        list.insert(first, key | rank);
+        return;
+    }
+    *first = key | rank;
+    list.erase(first + 1, end);
+}
+
+template<typename T, std::size_t k, typename Hash>
+void sliding_hyper_log_log<T, k, Hash>::add_hash(hash_result_type hash_value, timestamp_type now)
+{
+    auto& list = m_lists[hll::details::register_index(hash_value, k)];
+    const auto expired = std::partition_point(list.begin(), list.end(), [this, now](entry_type entry)
+    {
+        return !inside(timestamp_of(entry), m_max_window, now);
+    });
+    list.erase(list.begin(), expired);
+    if (inside(now, m_max_window, now))
+        insert(list, now, hll::details::register_rank(hash_value, k));
+    m_latest = std::max(m_latest, now);
+}
+
+template<typename T, std::size_t k, typename Hash>
+auto sliding_hyper_log_log<T, k, Hash>::count(timestamp_type window, timestamp_type now) const -> size_type
+{
+    if (!queryable(now))
+        return 0;
+    std::vector<register_type> registers(registers_count);
+    window_registers(window, now, [&registers](size_type index, uint32_t rank)
+    {
+        registers[index] = static_cast<register_type>(rank);
+    });
+    const auto sums = hll::kernels::active().sum(registers.data(), registers_count);
+    return hll::details::estimate_cardinality(sums, registers_count, hash_bits);
+}
+
+template<typename T, std::size_t k, typename Hash>
+auto sliding_hyper_log_log<T, k, Hash>::sketch(timestamp_type window, timestamp_type now) const -> sketch_type
+{
+    sketch_type result{};
+    if (!queryable(now))
+        return result;
+    auto& registers = result.registers();
+    window_registers(window, now, [&registers](size_type index, uint32_t rank)
+    {
+        registers[index] = static_cast<register_type>(rank);
+    });
+    return result;
+}
+
+template<typename T, std::size_t k, typename Hash>
+void sliding_hyper_log_log<T, k, Hash>::expire(timestamp_type now) noexcept
+{
+    for (auto& list : m_lists)
+    {
+        const auto expired = std::partition_point(list.begin(), list.end(), [this, now](entry_type entry)
+        {
+            return !inside(timestamp_of(entry), m_max_window, now);
+        });
+        list.erase(list.begin(), expired);
+    }
+}
+
+template<typename T, std::size_t k, typename Hash>
+void sliding_hyper_log_log<T, k, Hash>::merge(const this_type& rhs)
+{
+    for (size_type index = 0; index < registers_count; ++index)
+    {
+        for (const auto entry : rhs.m_lists[index])
+        {
+            insert(m_lists[index], timestamp_of(entry), rank_of(entry));
+        }
+    }
+    m_latest = std::max(m_latest, rhs.m_latest);
+}
+
+} // namespace hll
+
+#endif //HLL_SLIDING_HYPER_LOG_LOG_HXX
@@ -6,6 +6,8 @@
 #ifndef HLL_TRAITS_HXX
 #define HLL_TRAITS_HXX
 
+#include <cstddef>
+#include <type_traits>
 #include <utility>
 
 namespace hll
@@ -52,17 +54,192 @@ struct has_size_member_function<T,
 {
 };
 
-template<typename T, typename Base = typename std::conditional<
-        has_data_member_function<T>::value    // has T::data
-        && has_size_member_function<T>::value    // has T::size
-        && std::is_fundamental<typename T::value_type>::value, // value_type is fundamental
-        std::true_type,
-        std::false_type>
-::type>
-struct is_ra_fundamental_container : Base
+/**
+ * A type trait to identify is the type a contiguous container of the fundamental types:
+ * has T::data and T::size member functions and a fundamental T::value_type
+ */
+template<typename T, typename = void>
+struct is_ra_fundamental_container : std::false_type
+{
+};
+
+template<typename T>
+struct is_ra_fundamental_container<T, void_t<typename T::value_type>>
+        : std::integral_constant<bool,
+                has_data_member_function<T>::value    // has T::data
+                && has_size_member_function<T>::value    // has T::size
+                && std::is_fundamental<typename T::value_type>::value> // value_type is fundamental
+{
+};
+
+/**
+ * A type trait to identify is the type a contiguous container of bytes or characters, like std::string_view
+ */
+template<typename T, typename = void>
+struct is_byte_container : std::false_type
+{
+};
+
+template<typename T>
+struct is_byte_container<T, void_t<typename T::value_type>>
+        : std::integral_constant<bool, is_ra_fundamental_container<T>::value
+                                       && std::is_integral<typename T::value_type>::value
+                                       && sizeof(typename T::value_type) == 1>
+{
+};
+
+/**
+ * A type trait to identify is the type a hash policy for values of type T:
+ * has result_type member type and is callable with const T& returning something convertible to it
+ */
+template<typename Hash, typename T, typename = void>
+struct is_hash_policy_for : std::false_type
+{
+};
+
+template<typename Hash, typename T>
+struct is_hash_policy_for<Hash, T,
+        void_t<typename Hash::result_type, decltype(std::declval<const Hash&>()(std::declval<const T&>()))>>
+        : std::is_convertible<decltype(std::declval<const Hash&>()(std::declval<const T&>())),
+                              typename Hash::result_type>
+{
+};
+
+/**
+ * A type trait to identify are all the types the same
+ */
+template<typename... Ts>
+struct are_same : std::true_type
+{
+};
+
+template<typename T, typename U, typename... Ts>
+struct are_same<T, U, Ts...> : std::integral_constant<bool, std::is_same<T, U>::value && are_same<U, Ts...>::value>
+{
+};
+
+/// std::index_sequence implementation to use in C++11
+template<std::size_t... Is>
+struct index_sequence
+{
+};
+
+template<std::size_t N, std::size_t... Is>
+struct make_index_sequence_impl : make_index_sequence_impl<N - 1, N - 1, Is...>
+{
+};
+
+template<std::size_t... Is>
+struct make_index_sequence_impl<0, Is...>
+{
+    using type = index_sequence<Is...>;
+};
+
+/// std::make_index_sequence implementation to use in C++11
+template<std::size_t N>
+using make_index_sequence = typename make_index_sequence_impl<N>::type;
+
+/**
+ * A type trait to identify does the hash policy hash byte strings by the batch:
+ * has hash_batch(const void* const* keys, const std::size_t* lengths, std::size_t count, result_type* hashes)
+ */
+template<typename Hash, typename = void>
+struct has_hash_batch : std::false_type
+{
+};
+
+template<typename Hash>
+struct has_hash_batch<Hash,
+        void_t<decltype(std::declval<const Hash&>().hash_batch(std::declval<const void* const*>(),
+                                                               std::declval<const std::size_t*>(),
+                                                               std::declval<std::size_t>(),
+                                                               std::declval<typename Hash::result_type*>()))>>
+        : std::true_type
+{
+};
+
+/**
+ * A type trait to identify is the hash policy transparent: declares is_transparent member type to promise
+ * that it hashes contiguous containers by their bytes, so containers with equal elements hash alike
+ */
+template<typename Hash, typename = void>
+struct is_transparent_hash : std::false_type
+{
+};
+
+template<typename Hash>
+struct is_transparent_hash<Hash, void_t<typename Hash::is_transparent>> : std::true_type
+{
+};
+
+/**
+ * A type trait to identify are both types contiguous containers of the same fundamental type,
+ * like std::string, std::string_view and std::vector<char>
+ */
+template<typename T, typename U, typename = void>
+struct is_same_elements_container : std::false_type
 {
 };
 
+template<typename T, typename U>
+struct is_same_elements_container<T, U, void_t<typename T::value_type, typename U::value_type>>
+        : std::integral_constant<bool,
+                is_ra_fundamental_container<T>::value && is_ra_fundamental_container<U>::value
+                && std::is_same<typename std::remove_cv<typename T::value_type>::type,
+                                typename std::remove_cv<typename U::value_type>::type>::value>
+{
+};
+
+/**
+ * A type trait to identify is the type a character type, the only elements of a C string
+ */
+template<typename T>
+struct is_character
+        : std::integral_constant<bool,
+                std::is_same<T, char>::value || std::is_same<T, signed char>::value
+                || std::is_same<T, unsigned char>::value || std::is_same<T, wchar_t>::value
+                || std::is_same<T, char16_t>::value || std::is_same<T, char32_t>::value
+#if defined(__cpp_char8_t)
+                || std::is_same<T, char8_t>::value
+#endif
+        >
+{
+};
+
+/**
+ * A type trait to identify is U a C string or a character array of the characters of the container T:
+ * arrays of other elements have no terminator, so they are not keys
+ */
+template<typename T, typename U, typename = void>
+struct is_c_string_of : std::false_type
+{
+};
+
+template<typename T, typename U>
+struct is_c_string_of<T, U, void_t<typename T::value_type>>
+        : std::integral_constant<bool,
+                is_ra_fundamental_container<T>::value
+                && (std::is_array<U>::value || std::is_pointer<U>::value)
+                && std::is_same<typename std::remove_cv<typename std::remove_pointer<
+                                        typename std::decay<U>::type>::type>::type,
+                                typename T::value_type>::value
+                && is_character<typename T::value_type>::value>
+{
+};
+
+/**
+ * A type trait to identify can values of type U be added to a sketch of values of type T hashed by Hash
+ * as they were T, without converting them to T: the hash policy is transparent and U is a contiguous container
+ * of the same elements as T, a C string or a character array
+ */
+template<typename Hash, typename T, typename U>
+struct is_heterogeneous_key_for
+        : std::integral_constant<bool,
+                is_transparent_hash<Hash>::value
+                && !std::is_same<T, U>::value
+                && (is_same_elements_container<T, U>::value || is_c_string_of<T, U>::value)>
+{
+};
 
 } // namespace traits
 } // namespace hll
@@ -0,0 +1,120 @@
+/**
+ * @file tests/range_add_test.cpp
+ * @brief Adding a range gives the same registers as adding its elements one by one
+ * @author Daniil Dudkin (unterumarmung)
+ *
+ * The elements of a range may be of another type than the sketch's values: they are converted as add(value) converts
+ * them, unless they hash as the values without conversion. Every sketch type is fed both ways and compared.
+ */
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "hll/concurrent_sketch_map.hxx"
+#include "hll/dynamic_hyper_log_log.hxx"
+#include "hll/hyper_log_log.hxx"
+
+namespace
+{
+
+int failures = 0;
+
+void expect(bool condition, const char* name)
+{
+    std::printf("%s\t%s\n", condition ? "ok" : "FAILED", name);
+    if (!condition)
+        ++failures;
+}
+
+/// distinct ints, negative ones too, so converting them to uint64_t changes their bytes
+std::vector<int> make_ints()
+{
+    std::vector<int> result;
+    for (int i = -50000; i < 50000; ++i)
+    {
+        result.push_back(i * 7919);
+    }
+    return result;
+}
+
+std::vector<std::string> make_strings()
+{
+    std::vector<std::string> result;
+    for (int i = 0; i < 20000; ++i)
+    {
+        result.push_back("key:" + std::to_string(i));
+    }
+    return result;
+}
+
+template<typename Sketch, typename Range>
+void check_sketch(Sketch one_by_one, Sketch by_range, const Range& values, const char* name)
+{
+    for (const auto& value : values)
+    {
+        one_by_one.add(value);
+    }
+    by_range.add(values.begin(), values.end());
+    expect(one_by_one.registers() == by_range.registers(), name);
+}
+
+void check_add_all(const std::vector<int>& values)
+{
+    hll::hyper_log_log<uint64_t, 12> one_by_one{};
+    hll::hyper_log_log<uint64_t, 10> one_by_one_low{};
+    hll::hyper_log_log<uint64_t, 12> by_range{};
+    hll::hyper_log_log<uint64_t, 10> by_range_low{};
+    for (const auto value : values)
+    {
+        hll::add_all(value, one_by_one, one_by_one_low);
+    }
+    hll::add_all(values.begin(), values.end(), by_range, by_range_low);
+    expect(one_by_one.registers() == by_range.registers() && one_by_one_low.registers() == by_range_low.registers(),
+           "add_all\tint range to uint64_t sketches");
+}
+
+void check_sketch_map(const std::vector<int>& values)
+{
+    using sketch_map = hll::concurrent_sketch_map<int, uint64_t, 12>;
+    sketch_map one_by_one;
+    sketch_map by_range;
+    for (const auto value : values)
+    {
+        one_by_one.add(1, value);
+    }
+    by_range.add(1, values.begin(), values.end());
+    expect(one_by_one.sketch(1).registers() == by_range.sketch(1).registers(),
+           "concurrent_sketch_map\tint range to uint64_t sketch");
+}
+
+} // namespace
+
+int main()
+{
+    const auto ints = make_ints();
+    const auto strings = make_strings();
+    std::vector<const char*> c_strings;
+    std::vector<std::vector<char>> char_vectors;
+    for (const auto& value : strings)
+    {
+        c_strings.push_back(value.c_str());
+        char_vectors.emplace_back(value.begin(), value.end());
+    }
+
+    check_sketch(hll::hyper_log_log<uint64_t, 12>{}, hll::hyper_log_log<uint64_t, 12>{}, ints,
+                 "hyper_log_log\tint range to uint64_t sketch");
+    check_sketch(hll::hyper_log_log<uint64_t, 12, hll::murmur64a_hash>{},
+                 hll::hyper_log_log<uint64_t, 12, hll::murmur64a_hash>{}, ints,
+                 "hyper_log_log\tint range to uint64_t sketch, 64-bit hash");
+    check_sketch(hll::hyper_log_log<std::string, 12>{}, hll::hyper_log_log<std::string, 12>{}, strings,
+                 "hyper_log_log\tstring range to string sketch");
+    check_sketch(hll::hyper_log_log<std::string, 12>{}, hll::hyper_log_log<std::string, 12>{}, c_strings,
+                 "hyper_log_log\tC string range to string sketch");
+    check_sketch(hll::hyper_log_log<std::string, 12>{}, hll::hyper_log_log<std::string, 12>{}, char_vectors,
+                 "hyper_log_log\tchar vector range to string sketch");
+    check_sketch(hll::dynamic_hyper_log_log<uint64_t>(12), hll::dynamic_hyper_log_log<uint64_t>(12), ints,
+                 "dynamic_hyper_log_log\tint range to uint64_t sketch");
+    check_add_all(ints);
+    check_sketch_map(ints);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,147 @@
+/**
+ * @file tools/delimited.hxx
+ * @brief Tokenizing of delimiter-separated records (CSV, TSV) without copying the fields
+ * @author Daniil Dudkin (unterumarmung)
+ */
+#ifndef HLL_TOOLS_DELIMITED_HXX
+#define HLL_TOOLS_DELIMITED_HXX
+
+#include "line_scanner.hxx"
+
+namespace hll
+{
+namespace tools
+{
+namespace details
+{
+
+/**
+ * Field boundaries tracking, fed with the positions of delimiters, quotes and line breaks in order;
+ * every other fed position is a delimiter
+ */
+template<typename F>
+class field_splitter
+{
+public:
+    field_splitter(const char* begin, F& f) noexcept
+            : m_field(begin), m_f(f)
+    {
+    }
+
+    void on_special(const char* position, const char* end)
+    {
+        const auto c = *position;
+        if (c == '"')
+        {
+            on_quote(position, end);
+        } else if (c == '\n')
+        {
+            emit(position, true);
+            m_column = 0;
+        } else if (!m_in_quotes)
+        {
+            emit(position, false);
+        }
+    }
+
+    void finish(const char* end)
+    {
+        if (m_field != end || m_column != 0)
+            emit(end, true);
+    }
+
+private:
+    void on_quote(const char* position, const char* end) noexcept
+    {
+        if (position == m_skip)
+            return;
+
+        if (m_in_quotes)
+        {
+            if (position + 1 != end && position[1] == '"')
+            { // an escaped quote, the pair stays in the field as is
+                m_skip = position + 1;
+                return;
+            }
+            m_in_quotes = false;
+            m_quoted_end = position;
+        } else if (position == m_field)
+        {
+            m_in_quotes = true;
+            m_quoted = true;
+        }
+    }
+
+    void emit(const char* position, bool record_end)
+    {
+        auto first = m_field;
+        auto last = position;
+        if (m_quoted)
+        {
+            ++first;
+            if (m_quoted_end != nullptr)
+                last = m_quoted_end;
+        } else if (record_end && last != first && last[-1] == '\r')
+        {
+            --last;
+        }
+
+        m_f(m_column++, first, last);
+        m_field = position + 1;
+        m_quoted = false;
+        m_in_quotes = false;
+        m_quoted_end = nullptr;
+    }
+
+    const char* m_field;
+    const char* m_quoted_end = nullptr;
+    const char* m_skip = nullptr;
+    std::size_t m_column = 0;
+    bool m_in_quotes = false;
+    bool m_quoted = false;
+    F& m_f;
+};
+
+} // namespace details
+
+/**
+ * Calls f(column, first, last) for every field of every record of the buffer, columns are 0-based.
+ * Records end with line breaks (an optional CR before them is dropped), the last one may lack it.
+ * A field starting with a quote is quoted: delimiters inside it are a part of it,
+ * the surrounding quotes are not and escaped quotes ("") are passed as is.
+ * Quoted fields cannot contain line breaks, so records can be split on any line break
+ * @param begin buffer begin
+ * @param end buffer end
+ * @param delimiter field delimiter
+ * @param f the callback
+ */
+template<typename F>
+void for_each_field(const char* begin, const char* end, char delimiter, F&& f)
+{
+    details::field_splitter<F> splitter(begin, f);
+    const char needles[] = {delimiter, '\n', '"'};
+
+    auto position = begin;
+    while (static_cast<std::size_t>(end - position) >= block_size)
+    {
+        auto mask = match_mask(position, needles, sizeof(needles));
+        while (mask != 0)
+        {
+            splitter.on_special(position + lowest_bit(mask), end);
+            mask &= mask - 1;
+        }
+        position += block_size;
+    }
+
+    for (; position != end; ++position)
+    {
+        if (*position == delimiter || *position == '\n' || *position == '"')
+            splitter.on_special(position, end);
+    }
+    splitter.finish(end);
+}
+
+} // namespace tools
+} // namespace hll
+
+#endif //HLL_TOOLS_DELIMITED_HXX
@@ -0,0 +1,363 @@
+/**
+ * @file tools/hll_count.cpp
+ * @brief Estimates the number of distinct lines of files, an approximate `sort -u | wc -l`,
+ * or the numbers of distinct values of the columns of CSV/TSV files
+ * @author Daniil Dudkin (unterumarmung)
+ */
+#include <algorithm> // std::max, std::find
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib> // std::exit, std::strtoul
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "hll/compression.hxx"
+#include "hll/redis.hxx"
+#include "tools/delimited.hxx"
+#include "tools/input.hxx"
+#include "tools/parallel.hxx"
+
+namespace
+{
+
+/// 64-bit hashes keep the estimate accurate far beyond 2^32 lines
+using sketch_type = hll::redis::sketch<std::string_view>;
+
+struct options
+{
+    std::vector<const char*> inputs;
+    const char* output = nullptr;
+    bool redis = false;
+    std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    /// field delimiter, counting whole lines if zero
+    char delimiter = 0;
+    /// selected 0-based columns, all if empty
+    std::vector<std::size_t> columns;
+    bool header = false;
+};
+
+/**
+ * Sketches of the selected columns, indexed by column; whole lines are column 0
+ */
+class column_sketches
+{
+public:
+    explicit column_sketches(const options& opts)
+            : m_columns(opts.columns)
+    {
+        for (const auto column : m_columns)
+        {
+            get(column);
+        }
+    }
+
+    sketch_type* get(std::size_t column)
+    {
+        if (column >= m_sketches.size())
+        {
+            if (!is_selected(column))
+                return nullptr;
+            m_sketches.resize(column + 1);
+        }
+        if (m_sketches[column] == nullptr && is_selected(column))
+            m_sketches[column].reset(new sketch_type{});
+        return m_sketches[column].get();
+    }
+
+    void merge(const column_sketches& other)
+    {
+        for (std::size_t column = 0; column < other.m_sketches.size(); ++column)
+        {
+            if (other.m_sketches[column] != nullptr)
+                get(column)->merge(*other.m_sketches[column]);
+        }
+    }
+
+    std::size_t size() const noexcept
+    {
+        return m_sketches.size();
+    }
+
+    const sketch_type* at(std::size_t column) const noexcept
+    {
+        return m_sketches[column].get();
+    }
+
+private:
+    bool is_selected(std::size_t column) const
+    {
+        return m_columns.empty() || std::find(m_columns.begin(), m_columns.end(), column) != m_columns.end();
+    }
+
+    std::vector<std::size_t> m_columns;
+    std::vector<std::unique_ptr<sketch_type>> m_sketches;
+};
+
+void print_usage(std::FILE* stream)
+{
+    std::fputs("usage: hll_count [-d DELIM [-c LIST] [--header]] [-j N] [-o FILE [--redis]] [FILE...]\n"
+               "Prints the estimated number of distinct lines of the files, '-' or no files read stdin.\n"
+               "  -d, --delimiter C  count distinct values of every column of C-delimited records instead,\n"
+               "                     'tab' or '\\t' for TSV; quoted fields must not contain line breaks\n"
+               "  -c, --columns LIST count only the listed 1-based columns, e.g. 1,3,5-7\n"
+               "  --header           name the columns after the first record of the first file,\n"
+               "                     the first records of all files are skipped\n"
+               "  -j, --threads N    scan regular files with N threads, all hardware threads by default\n"
+               "  -o, --output FILE  also write the sketch to FILE, entropy-coded by default;\n"
+               "                     the sketch of column N is written to FILE.N\n"
+               "  --redis            write the sketch as a Redis HyperLogLog string instead\n", stream);
+}
+
+bool parse_columns(const char* list, std::vector<std::size_t>& columns)
+{
+    while (true)
+    {
+        char* end = nullptr;
+        const auto first = std::strtoul(list, &end, 10);
+        auto last = first;
+        if (end == list || first == 0)
+            return false;
+        if (*end == '-')
+        {
+            list = end + 1;
+            last = std::strtoul(list, &end, 10);
+            if (end == list || last < first)
+                return false;
+        }
+        for (auto column = first; column <= last; ++column)
+        {
+            columns.push_back(column - 1);
+        }
+        if (*end == '\0')
+            return true;
+        if (*end != ',')
+            return false;
+        list = end + 1;
+    }
+}
+
+bool parse_options(int argc, char** argv, options& result)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string argument = argv[i];
+        if (argument == "-o" || argument == "--output")
+        {
+            if (++i == argc)
+                return false;
+            result.output = argv[i];
+        } else if (argument == "-j" || argument == "--threads")
+        {
+            if (++i == argc)
+                return false;
+            char* end = nullptr;
+            result.threads = std::strtoul(argv[i], &end, 10);
+            if (*end != '\0' || result.threads == 0)
+                return false;
+        } else if (argument == "-d" || argument == "--delimiter")
+        {
+            if (++i == argc)
+                return false;
+            const std::string delimiter = argv[i];
+            if (delimiter == "tab" || delimiter == "\\t")
+                result.delimiter = '\t';
+            else if (delimiter.size() == 1 && delimiter[0] != '"' && delimiter[0] != '\n')
+                result.delimiter = delimiter[0];
+            else
+                return false;
+        } else if (argument == "-c" || argument == "--columns")
+        {
+            if (++i == argc || !parse_columns(argv[i], result.columns))
+                return false;
+        } else if (argument == "--header")
+        {
+            result.header = true;
+        } else if (argument == "--redis")
+        {
+            result.redis = true;
+        } else if (argument == "-h" || argument == "--help")
+        {
+            print_usage(stdout);
+            std::exit(0);
+        } else if (argument.size() > 1 && argument[0] == '-')
+        {
+            return false;
+        } else
+        {
+            result.inputs.push_back(argv[i]);
+        }
+    }
+    if (result.inputs.empty())
+        result.inputs.push_back("-");
+    if (result.delimiter == 0 && (!result.columns.empty() || result.header))
+        return false;
+    if (result.delimiter == 0)
+        result.columns.push_back(0);
+    return true;
+}
+
+/**
+ * Sketches the lines or the fields of the records of a buffer
+ */
+class scanner
+{
+public:
+    explicit scanner(const options& opts)
+            : m_opts(opts)
+    {
+    }
+
+    void add(const char* first, const char* last, column_sketches& sketches) const
+    {
+        if (m_opts.delimiter == 0)
+        {
+            auto& sketch = *sketches.get(0);
+            hll::tools::for_each_line(first, last, [&sketch](const char* line_first, const char* line_last)
+            {
+                sketch.add(std::string_view(line_first, static_cast<std::size_t>(line_last - line_first)));
+            });
+            return;
+        }
+
+        hll::tools::for_each_field(first, last, m_opts.delimiter,
+                                   [&sketches](std::size_t column, const char* field_first, const char* field_last)
+                                   {
+                                       const auto sketch = sketches.get(column);
+                                       if (sketch != nullptr)
+                                           sketch->add(std::string_view(
+                                                   field_first, static_cast<std::size_t>(field_last - field_first)));
+                                   });
+    }
+
+    /**
+     * Skips the header record if requested, remembering the column names from the first one
+     * @return the start of the data records
+     */
+    const char* skip_header(const char* first, const char* last, std::vector<std::string>& names) const
+    {
+        if (!m_opts.header)
+            return first;
+
+        const auto record_end = static_cast<const char*>(std::memchr(first, '\n', last - first));
+        const auto data = record_end == nullptr ? last : record_end + 1;
+        if (names.empty())
+        {
+            hll::tools::for_each_field(first, data, m_opts.delimiter,
+                                       [&names](std::size_t, const char* name_first, const char* name_last)
+                                       {
+                                           names.emplace_back(name_first, name_last);
+                                       });
+        }
+        return data;
+    }
+
+private:
+    const options& m_opts;
+};
+
+bool add_input(const char* path, const options& opts, column_sketches& sketches, std::vector<std::string>& names)
+{
+    const scanner scan(opts);
+    auto header_pending = true;
+    const auto add_block = [&](const char* first, const char* last)
+    {
+        if (header_pending)
+        {
+            first = scan.skip_header(first, last, names);
+            header_pending = false;
+        }
+        scan.add(first, last, sketches);
+    };
+
+    if (std::strcmp(path, "-") == 0)
+        return hll::tools::for_each_block(stdin, add_block);
+
+    const hll::tools::mapped_file mapping(path);
+    if (mapping.is_open())
+    {
+        const auto begin = scan.skip_header(mapping.data(), mapping.data() + mapping.size(), names);
+        // every thread fills its own sketches from whole-record chunks, merging them gives the sketches of the file
+        const auto partial = hll::tools::process_chunks<column_sketches>(
+                begin, mapping.data() + mapping.size(), opts.threads,
+                [&opts] { return std::unique_ptr<column_sketches>(new column_sketches(opts)); },
+                [&scan](column_sketches& chunk_sketches, const char* first, const char* last)
+                {
+                    scan.add(first, last, chunk_sketches);
+                });
+        for (const auto& chunk_sketches : partial)
+        {
+            sketches.merge(*chunk_sketches);
+        }
+        return true;
+    }
+
+    // not mappable (a pipe, a device or no mmap on the platform), read it as a stream
+    const auto file = std::fopen(path, "rb");
+    if (file == nullptr)
+        return false;
+    const auto result = hll::tools::for_each_block(file, add_block);
+    std::fclose(file);
+    return result;
+}
+
+bool write_sketch(const options& opts, const std::string& path, const sketch_type& sketch)
+{
+    const auto bytes = opts.redis ? hll::redis::encode(sketch) : hll::compression::encode(sketch);
+    const auto file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr)
+        return false;
+    const auto written = std::fwrite(bytes.data(), 1, bytes.size(), file);
+    return std::fclose(file) == 0 && written == bytes.size();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    options opts;
+    if (!parse_options(argc, argv, opts))
+    {
+        print_usage(stderr);
+        return 2;
+    }
+
+    column_sketches sketches(opts);
+    std::vector<std::string> names;
+    for (const auto path : opts.inputs)
+    {
+        if (!add_input(path, opts, sketches, names))
+        {
+            std::fprintf(stderr, "hll_count: %s: %s\n", path, std::strerror(errno));
+            return 1;
+        }
+    }
+
+    for (std::size_t column = 0; column < sketches.size(); ++column)
+    {
+        const auto sketch = sketches.at(column);
+        if (sketch == nullptr)
+            continue;
+
+        if (opts.output != nullptr)
+        {
+            const auto path = opts.delimiter == 0 ? std::string(opts.output)
+                                                  : std::string(opts.output) + '.' + std::to_string(column + 1);
+            if (!write_sketch(opts, path, *sketch))
+            {
+                std::fprintf(stderr, "hll_count: %s: %s\n", path.c_str(), std::strerror(errno));
+                return 1;
+            }
+        }
+
+        if (opts.delimiter == 0)
+            std::printf("%zu\n", sketch->count());
+        else if (column < names.size())
+            std::printf("%s\t%zu\n", names[column].c_str(), sketch->count());
+        else
+            std::printf("%zu\t%zu\n", column + 1, sketch->count());
+    }
+    return 0;
+}
@@ -0,0 +1,156 @@
+/**
+ * @file tools/input.hxx
+ * @brief Memory-mapped files and block-wise reading of streams
+ * @author Daniil Dudkin (unterumarmung)
+ */
+#ifndef HLL_TOOLS_INPUT_HXX
+#define HLL_TOOLS_INPUT_HXX
+
+#include <algorithm> // std::copy
+#include <cstdio>
+#include <vector>
+#include "line_scanner.hxx"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define HLL_TOOLS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace hll
+{
+namespace tools
+{
+
+/**
+ * Read-only memory mapping of a whole regular file.
+ * Not open if the platform has no mmap or the file is not a regular one, read it as a stream then
+ */
+class mapped_file
+{
+public:
+    explicit mapped_file(const char* path) noexcept
+    {
+#if HLL_TOOLS_MMAP
+        const auto descriptor = ::open(path, O_RDONLY);
+        if (descriptor < 0)
+            return;
+
+        struct stat info{};
+        if (::fstat(descriptor, &info) == 0 && S_ISREG(info.st_mode))
+        {
+            m_size = static_cast<std::size_t>(info.st_size);
+            if (m_size == 0)
+            {
+                m_open = true;
+            } else
+            {
+                const auto address = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+                if (address != MAP_FAILED)
+                {
+                    ::madvise(address, m_size, MADV_SEQUENTIAL);
+                    m_data = static_cast<const char*>(address);
+                    m_open = true;
+                }
+            }
+        }
+        ::close(descriptor);
+#else
+        (void) path;
+#endif
+    }
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    ~mapped_file()
+    {
+#if HLL_TOOLS_MMAP
+        if (m_data != nullptr)
+            ::munmap(const_cast<char*>(m_data), m_size);
+#endif
+    }
+
+    bool is_open() const noexcept
+    {
+        return m_open;
+    }
+
+    const char* data() const noexcept
+    {
+        return m_data;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+private:
+    const char* m_data = nullptr;
+    std::size_t m_size = 0;
+    bool m_open = false;
+};
+
+/// size of blocks read from streams
+constexpr std::size_t stream_block_size = 4u << 20u;
+
+/**
+ * Reads the stream in large blocks and calls f(first, last) for every block of whole lines:
+ * a line spanning a block boundary is carried over to the next block
+ * @param file the stream
+ * @param f the callback
+ * @return false on a read error
+ */
+template<typename F>
+bool for_each_block(std::FILE* file, F&& f)
+{
+    std::vector<char> buffer(stream_block_size);
+    std::size_t carried = 0;
+    while (true)
+    {
+        if (carried == buffer.size())
+            buffer.resize(buffer.size() * 2); // a single line longer than the buffer
+
+        const auto read = std::fread(buffer.data() + carried, 1, buffer.size() - carried, file);
+        if (read == 0)
+            break;
+
+        const auto begin = static_cast<const char*>(buffer.data());
+        const auto end = begin + carried + read;
+        auto tail = end;
+        while (tail != begin && tail[-1] != '\n')
+            --tail;
+
+        if (tail != begin)
+            f(begin, tail);
+        carried = static_cast<std::size_t>(end - tail);
+        std::copy(tail, end, buffer.data());
+    }
+
+    if (carried != 0)
+        f(static_cast<const char*>(buffer.data()), buffer.data() + carried);
+    return std::ferror(file) == 0;
+}
+
+/**
+ * Reads the stream in large blocks and calls f(first, last) for every line
+ * @param file the stream
+ * @param f the callback
+ * @return false on a read error
+ */
+template<typename F>
+bool for_each_line(std::FILE* file, F&& f)
+{
+    return for_each_block(file, [&f](const char* first, const char* last)
+    {
+        hll::tools::for_each_line(first, last, f);
+    });
+}
+
+} // namespace tools
+} // namespace hll
+
+#endif //HLL_TOOLS_INPUT_HXX
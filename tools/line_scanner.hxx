@@ -0,0 +1,159 @@
+/**
+ * @file tools/line_scanner.hxx
+ * @brief SIMD scanning of byte buffers for separators
+ * @author Daniil Dudkin (unterumarmung)
+ */
+#ifndef HLL_TOOLS_LINE_SCANNER_HXX
+#define HLL_TOOLS_LINE_SCANNER_HXX
+
+#include <cstdint>
+#include <cstring> // std::memchr
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HLL_TOOLS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace hll
+{
+namespace tools
+{
+
+/// number of bytes the scanners look at per step
+constexpr std::size_t block_size = 64;
+
+/**
+ * Index of the lowest set bit
+ * @param mask non-zero mask
+ * @return the index
+ */
+inline uint32_t lowest_bit(uint64_t mask) noexcept
+{
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanForward64(&index, mask);
+    return static_cast<uint32_t>(index);
+#else
+    return static_cast<uint32_t>(__builtin_ctzll(mask));
+#endif
+}
+
+/**
+ * Finds the bytes of a 64-byte block equal to the needle
+ * @param block pointer to at least block_size bytes
+ * @param needle the byte to find
+ * @return mask with bit i set if block[i] == needle
+ */
+inline uint64_t match_mask(const char* block, char needle) noexcept
+{
+#if HLL_TOOLS_SSE2
+    const auto pattern = _mm_set1_epi8(needle);
+    uint64_t mask = 0;
+    for (std::size_t i = 0; i < block_size; i += 16)
+    {
+        const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+        mask |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, pattern)))) << i;
+    }
+    return mask;
+#else
+    uint64_t mask = 0;
+    for (std::size_t i = 0; i < block_size; ++i)
+    {
+        mask |= static_cast<uint64_t>(block[i] == needle) << i;
+    }
+    return mask;
+#endif
+}
+
+/**
+ * Finds the bytes of a 64-byte block equal to any of the needles
+ * @param block pointer to at least block_size bytes
+ * @param needles the bytes to find
+ * @param needle_count number of the needles
+ * @return mask with bit i set if block[i] is one of the needles
+ */
+inline uint64_t match_mask(const char* block, const char* needles, std::size_t needle_count) noexcept
+{
+#if HLL_TOOLS_SSE2
+    uint64_t mask = 0;
+    for (std::size_t i = 0; i < block_size; i += 16)
+    {
+        const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+        auto matches = _mm_setzero_si128();
+        for (std::size_t j = 0; j < needle_count; ++j)
+        {
+            matches = _mm_or_si128(matches, _mm_cmpeq_epi8(bytes, _mm_set1_epi8(needles[j])));
+        }
+        mask |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(matches))) << i;
+    }
+    return mask;
+#else
+    uint64_t mask = 0;
+    for (std::size_t i = 0; i < needle_count; ++i)
+    {
+        mask |= match_mask(block, needles[i]);
+    }
+    return mask;
+#endif
+}
+
+/**
+ * Calls f(first, last) for every line of the buffer, the line terminator is not included.
+ * The last line may lack the terminator, an empty buffer has no lines
+ * @param begin buffer begin
+ * @param end buffer end
+ * @param f the callback
+ * @return pointer past the last terminator, i.e. the start of the unterminated tail
+ */
+template<typename F>
+const char* for_each_terminated_line(const char* begin, const char* end, F&& f)
+{
+    auto line = begin;
+    auto position = begin;
+    while (static_cast<std::size_t>(end - position) >= block_size)
+    {
+        auto mask = match_mask(position, '\n');
+        while (mask != 0)
+        {
+            const auto terminator = position + lowest_bit(mask);
+            f(line, terminator);
+            line = terminator + 1;
+            mask &= mask - 1;
+        }
+        position += block_size;
+    }
+
+    while (position != end)
+    {
+        const auto terminator = static_cast<const char*>(std::memchr(position, '\n', end - position));
+        if (terminator == nullptr)
+            break;
+        f(line, terminator);
+        line = terminator + 1;
+        position = line;
+    }
+    return line;
+}
+
+/**
+ * Calls f(first, last) for every line of the buffer including the unterminated last one
+ * @param begin buffer begin
+ * @param end buffer end
+ * @param f the callback
+ */
+template<typename F>
+void for_each_line(const char* begin, const char* end, F&& f)
+{
+    const auto tail = for_each_terminated_line(begin, end, f);
+    if (tail != end)
+        f(tail, end);
+}
+
+} // namespace tools
+} // namespace hll
+
+#endif //HLL_TOOLS_LINE_SCANNER_HXX
@@ -0,0 +1,99 @@
+/**
+ * @file tools/parallel.hxx
+ * @brief Parallel processing of buffers split on record boundaries
+ * @author Daniil Dudkin (unterumarmung)
+ */
+#ifndef HLL_TOOLS_PARALLEL_HXX
+#define HLL_TOOLS_PARALLEL_HXX
+
+#include <algorithm> // std::max, std::min
+#include <atomic>
+#include <cstring> // std::memchr
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace hll
+{
+namespace tools
+{
+
+/// size of a chunk a worker takes at once, small enough to balance the load, large enough to amortize the handoff
+constexpr std::size_t chunk_size = 16u << 20u;
+
+/**
+ * Splits the buffer into chunks of about chunk_size bytes, each ending right after a terminator
+ * (or at the end of the buffer), so no record spans two chunks
+ * @param begin buffer begin
+ * @param end buffer end
+ * @param terminator record terminator
+ * @return chunk boundaries, chunk i is [result[i], result[i + 1])
+ */
+inline std::vector<const char*> split_chunks(const char* begin, const char* end, char terminator = '\n')
+{
+    std::vector<const char*> boundaries{begin};
+    auto position = begin;
+    while (static_cast<std::size_t>(end - position) > chunk_size)
+    {
+        const auto nominal = position + chunk_size;
+        const auto found = static_cast<const char*>(std::memchr(nominal, terminator, end - nominal));
+        if (found == nullptr)
+            break;
+        position = found + 1;
+        boundaries.push_back(position);
+    }
+    if (boundaries.back() != end)
+        boundaries.push_back(end);
+    return boundaries;
+}
+
+/**
+ * Processes chunks of the buffer on several threads, every thread accumulating into its own state
+ * @param begin buffer begin
+ * @param end buffer end
+ * @param threads number of threads, the calling one included
+ * @param make_state creates a per-thread state
+ * @param process called as process(state, first, last) for every chunk
+ * @return the per-thread states, to be merged by the caller
+ */
+template<typename State, typename MakeState, typename Process>
+std::vector<std::unique_ptr<State>> process_chunks(const char* begin, const char* end, std::size_t threads,
+                                                   MakeState make_state, Process process)
+{
+    const auto boundaries = split_chunks(begin, end);
+    const auto chunks = boundaries.size() - 1;
+    threads = std::max<std::size_t>(1, std::min(threads, chunks));
+
+    std::vector<std::unique_ptr<State>> states;
+    for (std::size_t i = 0; i < threads; ++i)
+    {
+        states.push_back(make_state());
+    }
+
+    std::atomic<std::size_t> next_chunk{0};
+    const auto work = [&](State& state)
+    {
+        for (auto chunk = next_chunk++; chunk < chunks; chunk = next_chunk++)
+        {
+            process(state, boundaries[chunk], boundaries[chunk + 1]);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (std::size_t i = 1; i < threads; ++i)
+    {
+        workers.emplace_back(work, std::ref(*states[i]));
+    }
+    work(*states[0]);
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+    return states;
+}
+
+} // namespace tools
+} // namespace hll
+
+#endif //HLL_TOOLS_PARALLEL_HXX